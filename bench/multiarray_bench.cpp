@@ -0,0 +1,471 @@
+/*! \file multiarray_bench.cpp
+ *  \brief Benchmarks of host_multiarray and device_multiarray against array of structures.
+ *
+ *         Every result is printed as one JSON object per line.
+ *
+ *         Usage: multiarray_bench [--min-rows N] [--max-rows N] [--repeat R]
+ */
+
+#include <muse/multiarray.h>
+#include <muse/multiarray/detail/column_loop.inl>
+
+#include <thrust/copy.h>
+#include <thrust/gather.h>
+#include <thrust/reduce.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/functional.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#ifndef MUSE_BENCH_BACKEND
+#define MUSE_BENCH_BACKEND "cpp"
+#endif
+
+
+namespace bench
+{
+
+    struct options
+    {
+        std::size_t min_rows;
+        std::size_t max_rows;
+        int repeat;
+
+        options(void)
+            : min_rows(1000), max_rows(16 * 1000 * 1000), repeat(5) {}
+    };
+
+
+    // Multiarray with C components of type T
+    template<template<typename, typename, typename, typename, typename,
+                      typename, typename, typename, typename, typename> class Multiarray,
+             int C, typename T>
+    struct soa
+    {
+        template<int I>
+        struct column
+        {
+            typedef typename std::conditional<(I < C), T, muse::null_type>::type type;
+        };
+
+        typedef Multiarray<typename column<0>::type, typename column<1>::type, typename column<2>::type,
+                           typename column<3>::type, typename column<4>::type, typename column<5>::type,
+                           typename column<6>::type, typename column<7>::type, typename column<8>::type,
+                           typename column<9>::type> type;
+    };
+
+
+    // Row of the array of structures baseline
+    template<int C, typename T>
+    struct row
+    {
+        T v[C];
+    };
+
+
+    template<typename T> const char* type_name(void);
+    template<> const char* type_name<float>(void) { return "float"; }
+    template<> const char* type_name<double>(void) { return "double"; }
+    template<> const char* type_name<int>(void) { return "int32"; }
+    template<> const char* type_name<long long>(void) { return "int64"; }
+
+
+    template<typename T> using host_vector = thrust::host_vector<T>;
+    template<typename T> using device_vector = thrust::device_vector<T>;
+
+
+    template<class F>
+    double measure(int repeat, F f)
+    {
+        double best = 1e300;
+        for (int r = 0; r < repeat; ++r)
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            f();
+            const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, s);
+        }
+        return best;
+    }
+
+
+    void report(const char* benchmark, const char* layout, const char* container,
+                const char* type, int columns, std::size_t rows, std::size_t bytes, double seconds)
+    {
+        std::cout << "{\"benchmark\": \"" << benchmark << "\""
+                  << ", \"layout\": \"" << layout << "\""
+                  << ", \"container\": \"" << container << "\""
+                  << ", \"backend\": \"" << MUSE_BENCH_BACKEND << "\""
+                  << ", \"type\": \"" << type << "\""
+                  << ", \"columns\": " << columns
+                  << ", \"rows\": " << rows
+                  << ", \"seconds\": " << seconds
+                  << ", \"bytes_per_second\": " << (seconds > 0 ? bytes / seconds : 0)
+                  << "}" << std::endl;
+    }
+
+
+    // Functors operating on single components
+
+    struct fill_column
+    {
+        int seed;
+
+        template<class V>
+        void operator()(V& v, int)
+        {
+            thrust::host_vector<typename V::value_type> h(v.size());
+            for (std::size_t i = 0; i < h.size(); ++i)
+            {
+                h[i] = static_cast<typename V::value_type>((i * 2654435761u + seed++) % 1000003);
+            }
+            thrust::copy(h.begin(), h.end(), v.begin());
+        }
+    };
+
+    struct sum_columns
+    {
+        double sum;
+
+        template<class V>
+        void operator()(const V& v, int)
+        {
+            sum += static_cast<double>(thrust::reduce(v.begin(), v.end()));
+        }
+    };
+
+    template<class Map>
+    struct gather_columns
+    {
+        const Map& map;
+
+        template<class Src, class Dst>
+        void operator()(const Src& src, Dst& dst)
+        {
+            thrust::gather(map.begin(), map.end(), src.begin(), dst.begin());
+        }
+    };
+
+    template<class Stencil>
+    struct compact_columns
+    {
+        const Stencil& stencil;
+        typename Stencil::value_type threshold;
+        std::size_t count;
+
+        template<class Src, class Dst>
+        void operator()(const Src& src, Dst& dst)
+        {
+            count = thrust::copy_if(src.begin(), src.end(), stencil.begin(), dst.begin(), above(threshold)) - dst.begin();
+        }
+
+        struct above
+        {
+            typename Stencil::value_type t;
+            explicit above(typename Stencil::value_type v) : t(v) {}
+            template<typename U> bool operator()(const U& u) const { return t < u; }
+        };
+    };
+
+    struct copy_columns
+    {
+        template<class Src, class Dst>
+        void operator()(const Src& src, Dst& dst)
+        {
+            thrust::copy(src.begin(), src.end(), dst.begin());
+        }
+    };
+
+
+    // Functors operating on rows of the baseline
+
+    template<int C, typename T>
+    struct row_first
+    {
+        double operator()(const row<C, T>& r) const { return r.v[0]; }
+    };
+
+    template<int C, typename T>
+    struct row_sum
+    {
+        double operator()(const row<C, T>& r) const
+        {
+            double s = 0;
+            for (int i = 0; i < C; ++i) s += r.v[i];
+            return s;
+        }
+    };
+
+    template<int C, typename T>
+    struct row_less
+    {
+        bool operator()(const row<C, T>& a, const row<C, T>& b) const { return a.v[0] < b.v[0]; }
+    };
+
+    template<int C, typename T>
+    struct row_above
+    {
+        T t;
+        explicit row_above(T v) : t(v) {}
+        bool operator()(const row<C, T>& r) const { return t < r.v[0]; }
+    };
+
+
+    /*
+     *   Runs all benchmarks for C components of type T with n rows.
+     *   SoA is a multiarray, AoS a vector of rows of the same memory space.
+     */
+    template<template<typename, typename, typename, typename, typename,
+                      typename, typename, typename, typename, typename> class Multiarray,
+             template<typename> class Vector,
+             int C, typename T>
+    void run(const char* container, std::size_t n, const options& opt)
+    {
+        typedef typename soa<Multiarray, C, T>::type array_type;
+        typedef row<C, T> row_type;
+        typedef Vector<row_type> aos_type;
+        typedef Vector<std::size_t> index_type;
+
+        const char* type = type_name<T>();
+        const std::size_t bytes = n * C * sizeof(T);
+
+        // construction and resize
+        report("construct_resize", "soa", container, type, C, n, 2 * bytes, measure(opt.repeat, [&]() {
+            array_type a(n);
+            a.resize(2 * n);
+        }));
+        report("construct_resize", "aos", container, type, C, n, 2 * bytes, measure(opt.repeat, [&]() {
+            aos_type a(n);
+            a.resize(2 * n);
+        }));
+
+        array_type a(n);
+        fill_column fill = { 1 };
+        muse::detail::for_each_column(fill, a);
+
+        const thrust::host_vector<T> first(muse::get<0>(a).begin(), muse::get<0>(a).end());
+        thrust::host_vector<row_type> staging(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            for (int c = 0; c < C; ++c)
+            {
+                staging[i].v[c] = first[i];
+            }
+        }
+        aos_type b(staging.begin(), staging.end());
+
+        // single-column scan
+        report("scan_single", "soa", container, type, C, n, n * sizeof(T), measure(opt.repeat, [&]() {
+            volatile double s = thrust::reduce(muse::get<0>(a).begin(), muse::get<0>(a).end());
+            (void)s;
+        }));
+        report("scan_single", "aos", container, type, C, n, n * sizeof(T), measure(opt.repeat, [&]() {
+            volatile double s = thrust::transform_reduce(b.begin(), b.end(), row_first<C, T>(), 0.0, thrust::plus<double>());
+            (void)s;
+        }));
+
+        // multi-column scan
+        report("scan_all", "soa", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            sum_columns s = { 0 };
+            muse::detail::for_each_column(s, a);
+        }));
+        report("scan_all", "aos", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            volatile double s = thrust::transform_reduce(b.begin(), b.end(), row_sum<C, T>(), 0.0, thrust::plus<double>());
+            (void)s;
+        }));
+
+        // gather with a random permutation
+        thrust::host_vector<std::size_t> host_map(n);
+        thrust::sequence(host_map.begin(), host_map.end());
+        std::srand(7);
+        for (std::size_t i = n; i > 1; --i)
+        {
+            std::swap(host_map[i - 1], host_map[std::rand() % i]);
+        }
+        index_type map(host_map.begin(), host_map.end());
+
+        report("gather", "soa", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            array_type out(n);
+            gather_columns<index_type> g = { map };
+            muse::detail::for_each_column_pair<0>(g, a, out);
+        }));
+        report("gather", "aos", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            aos_type out(n);
+            thrust::gather(map.begin(), map.end(), b.begin(), out.begin());
+        }));
+
+        // sort by first component
+        report("sort_by_column", "soa", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            Vector<T> keys(muse::get<0>(a).begin(), muse::get<0>(a).end());
+            index_type perm(n);
+            thrust::sequence(perm.begin(), perm.end());
+            thrust::sort_by_key(keys.begin(), keys.end(), perm.begin());
+            array_type out(n);
+            gather_columns<index_type> g = { perm };
+            muse::detail::for_each_column_pair<0>(g, a, out);
+        }));
+        report("sort_by_column", "aos", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            aos_type out(b.begin(), b.end());
+            thrust::sort(out.begin(), out.end(), row_less<C, T>());
+        }));
+
+        // compaction keeping rows whose first component is above median
+        const T threshold = static_cast<T>(1000003 / 2);
+        report("compact", "soa", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            array_type out(n);
+            compact_columns<typename muse::multiarray_element<0, array_type>::type> k = { muse::get<0>(a), threshold, 0 };
+            muse::detail::for_each_column_pair<0>(k, a, out);
+            out.resize(k.count);
+        }));
+        report("compact", "aos", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+            aos_type out(n);
+            out.resize(thrust::copy_if(b.begin(), b.end(), out.begin(), row_above<C, T>(threshold)) - out.begin());
+        }));
+
+        // transfer to the other memory space, host arrays to device and device arrays to host
+        typedef typename soa<muse::device_multiarray, C, T>::type device_array_type;
+        typedef typename soa<muse::host_multiarray, C, T>::type host_array_type;
+
+        if (std::is_same<array_type, host_array_type>::value)
+        {
+            report("copy_to_device", "soa", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+                device_array_type d(n);
+                copy_columns f;
+                muse::detail::for_each_column_pair<0>(f, a, d);
+            }));
+            report("copy_to_device", "aos", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+                thrust::device_vector<row_type> d(b.begin(), b.end());
+            }));
+        }
+        else
+        {
+            report("copy_to_host", "soa", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+                host_array_type h(n);
+                copy_columns f;
+                muse::detail::for_each_column_pair<0>(f, a, h);
+            }));
+            report("copy_to_host", "aos", container, type, C, n, bytes, measure(opt.repeat, [&]() {
+                thrust::host_vector<row_type> h(b.begin(), b.end());
+            }));
+        }
+    }
+
+
+    template<int C, typename T>
+    void run_containers(std::size_t n, const options& opt)
+    {
+        run<muse::host_multiarray, host_vector, C, T>("host", n, opt);
+        run<muse::device_multiarray, device_vector, C, T>("device", n, opt);
+    }
+
+
+    template<typename T>
+    void run_columns(std::size_t n, const options& opt)
+    {
+        run_containers<1, T>(n, opt);
+        run_containers<2, T>(n, opt);
+        run_containers<4, T>(n, opt);
+        run_containers<6, T>(n, opt);
+        run_containers<8, T>(n, opt);
+        run_containers<10, T>(n, opt);
+    }
+
+
+
+    /*
+     *   Bit-packed chunk kernels against the field by field reference, both
+     *   serial, so the ratio of "kernel" to "scalar" is the gain of the
+     *   vectorized kernels. Built without AVX2 both run the same code.
+     */
+    template<typename T, int Bits>
+    void run_encoding(const char* type, std::size_t n, const options& opt)
+    {
+        typedef muse::detail::packed_chunk_scalar<T, Bits> scalar;
+        typedef muse::detail::packed_chunk<T, Bits> kernel;
+
+        muse::bit_packed_vector<T, Bits> packed(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            packed[i] = static_cast<T>((i * 2654435761u) & muse::detail::low_mask(Bits - 1));
+        }
+
+        const std::string container = "bit_packed_" + std::to_string(Bits);
+        const muse::packed_word* w = &packed.words()[0];
+        const std::size_t chunks = n / 64;
+        const std::size_t bytes = chunks * Bits * sizeof(muse::packed_word);
+        const T lo = static_cast<T>(muse::detail::low_mask(Bits - 1) / 4);
+        const T hi = static_cast<T>(muse::detail::low_mask(Bits - 1) / 2);
+
+        thrust::host_vector<muse::packed_word> mask(chunks);
+        thrust::host_vector<T> values(chunks * 64);
+
+        report("select_between", "scalar", container.c_str(), type, 1, n, bytes, measure(opt.repeat, [&]() {
+            for (std::size_t c = 0; c < chunks; ++c)
+                mask[c] = scalar::between(w + c * Bits, lo, hi);
+        }));
+        report("select_between", "kernel", container.c_str(), type, 1, n, bytes, measure(opt.repeat, [&]() {
+            for (std::size_t c = 0; c < chunks; ++c)
+                mask[c] = kernel::between(w + c * Bits, lo, hi);
+        }));
+        report("unpack", "scalar", container.c_str(), type, 1, n, bytes, measure(opt.repeat, [&]() {
+            for (std::size_t c = 0; c < chunks; ++c)
+                scalar::decode(w + c * Bits, &values[c * 64]);
+        }));
+        report("unpack", "kernel", container.c_str(), type, 1, n, bytes, measure(opt.repeat, [&]() {
+            for (std::size_t c = 0; c < chunks; ++c)
+                kernel::decode(w + c * Bits, &values[c * 64]);
+        }));
+    }
+
+} // end namespace bench
+
+
+
+int main(int argc, char** argv)
+{
+    bench::options opt;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (0 == std::strcmp(argv[i], "--min-rows"))
+        {
+            opt.min_rows = std::strtoull(argv[i + 1], 0, 10);
+        }
+        else if (0 == std::strcmp(argv[i], "--max-rows"))
+        {
+            opt.max_rows = std::strtoull(argv[i + 1], 0, 10);
+        }
+        else if (0 == std::strcmp(argv[i], "--repeat"))
+        {
+            opt.repeat = std::atoi(argv[i + 1]);
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--min-rows N] [--max-rows N] [--repeat R]" << std::endl;
+            return 1;
+        }
+    }
+
+    for (std::size_t n = opt.min_rows; n <= opt.max_rows; n *= 10)
+    {
+        bench::run_columns<float>(n, opt);
+        bench::run_columns<double>(n, opt);
+        bench::run_columns<int>(n, opt);
+        bench::run_columns<long long>(n, opt);
+
+        bench::run_encoding<int, 3>("int32", n, opt);
+        bench::run_encoding<int, 8>("int32", n, opt);
+        bench::run_encoding<int, 12>("int32", n, opt);
+        bench::run_encoding<long long, 40>("int64", n, opt);
+    }
+
+    return 0;
+}
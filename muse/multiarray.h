@@ -4,4 +4,16 @@
 #pragma once
 
 #include <muse/multiarray/host_multiarray.h>
-#include <muse/multiarray/device_multiarray.h>
\ No newline at end of file
+#include <muse/multiarray/device_multiarray.h>
+#include <muse/multiarray/small_multiarray.h>
+#include <muse/multiarray/multiarray_view.h>
+#include <muse/multiarray/dynamic_multiarray.h>
+#include <muse/multiarray/group_by.h>
+#include <muse/multiarray/hash_join.h>
+#include <muse/multiarray/column_index.h>
+#include <muse/multiarray/concatenate.h>
+#include <muse/multiarray/partition.h>
+#include <muse/multiarray/ring_multiarray.h>
+#include <muse/multiarray/instrumentation.h>
+#include <muse/multiarray/arrow.h>
+#include <muse/multiarray/async.h>
@@ -0,0 +1,118 @@
+/*! \file arrow.h
+ *  \brief Zero-copy exchange of multiarrays through the Apache Arrow C data interface.
+ *
+ *         \p ArrowSchema and \p ArrowArray are defined here unless an Arrow
+ *         header defining ARROW_C_DATA_INTERFACE was included before.
+ */
+#pragma once
+
+#include <muse/multiarray/host_multiarray.h>
+#include <muse/multiarray/multiarray_view.h>
+#include <muse/multiarray/detail/arrow.inl>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Exports a \p host_multiarray_snapshot as an Arrow struct array with
+     *   one child array per container. Buffers are not copied, the exported
+     *   structures share containers with the snapshot and keep them alive
+     *   until their release callbacks are called.
+     *
+     *   Supported containers are those of integral and floating point element
+     *   types and \p packed_bool, exported as Arrow boolean. Containers of
+     *   \p bool are not bit-packed and are rejected by a static assertion.
+     *
+     *   \param s      snapshot to export
+     *   \param schema output schema, struct type "+s" with one child per container
+     *   \param array  output array
+     *   \param names  optional names of children, "0", "1", ... by default
+     */
+    template<typename T0, typename T1, typename T2, typename T3, typename T4,
+             typename T5, typename T6, typename T7, typename T8, typename T9>
+    void export_arrow(const host_multiarray_snapshot<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>& s,
+                      ArrowSchema* schema, ArrowArray* array, const char* const* names = 0)
+    {
+        muse::detail::export_arrow_snapshot(s, names, schema, array);
+    }
+
+
+    /*!
+     *   Exports current content of a \p host_multiarray as an Arrow struct
+     *   array without copying buffers. The export holds a snapshot, so later
+     *   writes to the multiarray copy the written container and do not affect
+     *   exported data. Has to be called by the thread modifying the multiarray.
+     *
+     *   \param a      multiarray to export
+     *   \param schema output schema, struct type "+s" with one child per container
+     *   \param array  output array
+     *   \param names  optional names of children, "0", "1", ... by default
+     *
+     *   The following code snippet demonstrates round trip through Arrow structures
+     *
+     *   \code
+     *   #include <muse/multiarray/arrow.h>
+     *
+     *   muse::host_multiarray<float, int> x(10000);
+     *
+     *   ArrowSchema schema;
+     *   ArrowArray array;
+     *   muse::export_arrow(x, &schema, &array);
+     *
+     *   muse::multiarray_view<const float, const int> v;
+     *   if (muse::import_arrow(&schema, &array, v))
+     *   {
+     *       float first = muse::get<0>(v)[0];
+     *   }
+     *
+     *   array.release(&array);
+     *   schema.release(&schema);
+     *
+     *   \endcode
+     */
+    template<typename T0, typename T1, typename T2, typename T3, typename T4,
+             typename T5, typename T6, typename T7, typename T8, typename T9>
+    void export_arrow(const host_multiarray<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>& a,
+                      ArrowSchema* schema, ArrowArray* array, const char* const* names = 0)
+    {
+        muse::detail::export_arrow_snapshot(a.snapshot(), names, schema, array);
+    }
+
+
+    /*!
+     *   Wraps an Arrow struct array as a non-owning \p multiarray_view.
+     *   Neither the struct array nor its children may have nulls. Every child
+     *   has to match element type of the view, be aligned for its element
+     *   type and cover offset and length of the struct array. The view does not take ownership,
+     *   the array has to stay unreleased while the view is in use.
+     *
+     *   \param schema schema of the array
+     *   \param array  struct array with one child per view
+     *   \param view   output view, element types have to be const
+     *   \return true on success; false, when buffers cannot be viewed as is,
+     *          view is then left in unspecified state
+     */
+    template<typename T0, typename T1, typename T2, typename T3, typename T4,
+             typename T5, typename T6, typename T7, typename T8, typename T9>
+    bool import_arrow(const ArrowSchema* schema, const ArrowArray* array,
+                      multiarray_view<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>& view)
+    {
+        typedef multiarray_view<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> view_type;
+
+        const int columns = multiarray_size<view_type>::value;
+
+        if (0 == schema->release || 0 == array->release
+            || 0 != std::strcmp(schema->format, "+s")
+            || schema->n_children != columns || array->n_children != columns
+            || (array->null_count != 0 && array->n_buffers > 0 && array->buffers[0] != 0))
+        {
+            return false;
+        }
+
+        return muse::detail::import_arrow_loop<0, multiarray_size<view_type>::value>::apply(schema, array, view);
+    }
+
+
+} // end namespace muse
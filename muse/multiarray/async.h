@@ -0,0 +1,367 @@
+/*! \file async.h
+ *  \brief Asynchronous multiarray operations chained into dependency graphs on a work-stealing thread pool.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/async.inl>
+#include <cassert>
+
+
+namespace muse
+{
+
+    namespace detail
+    {
+        struct async_access;
+    }
+
+
+    namespace async
+    {
+
+
+        /*!
+         *   Work-stealing thread pool running asynchronous operations. Every
+         *   worker thread has its own queue and steals from the others when
+         *   its queue is empty. Operations still running or waiting for
+         *   dependencies have to be waited for before the executor is destroyed.
+         */
+        class executor : public muse::detail::async_pool
+        {
+
+        private:
+            typedef muse::detail::async_pool inherited;
+
+        public:
+
+            /*!
+             *  This constructor creates an \p executor with one thread per hardware thread
+             */
+            executor(void)
+                : inherited(std::thread::hardware_concurrency()) {}
+
+            /*!
+             *  This constructor creates an \p executor with given number of threads
+             *  \param threads number of worker threads, at least one is created
+             */
+            explicit executor(std::size_t threads)
+                : inherited(threads) {}
+
+            /*!
+             *  Returns the \p executor shared by the whole process, created on first use
+             */
+            static executor& shared(void)
+            {
+                static executor e;
+                return e;
+            }
+
+        private:
+            executor(const executor&);
+            executor& operator=(const executor&);
+
+        }; // end class executor
+
+
+
+        /*!
+         *   Completion of an asynchronous operation. Futures are cheap to copy,
+         *   passed as \p after argument of another operation they make it start
+         *   once this one is finished. A default constructed \p future is ready.
+         *
+         *   An exception thrown by an operation, e.g. \p std::bad_alloc, finishes
+         *   it. Operations depending on it are finished without running and
+         *   \p wait on any of them rethrows the exception.
+         */
+        class future
+        {
+
+        public:
+
+            /*!
+             *  This constructor creates a ready \p future
+             */
+            future(void) {}
+
+            /*!
+             *  This method returns true once the operation is finished
+             */
+            bool ready(void) const { return !node || node->done; }
+
+            /*!
+             *  Blocks until the operation is finished and rethrows the exception
+             *  it or an operation it depended on threw. Must not be called by
+             *  an operation running on the same executor, which could then wait
+             *  for operations queued behind it; chain with \p then or pass the
+             *  \p future as \p after instead.
+             */
+            void wait(void) const
+            {
+                if (node)
+                {
+                    node->pool->wait(*node);
+                    if (node->error)
+                    {
+                        std::rethrow_exception(node->error);
+                    }
+                }
+            }
+
+            /*!
+             *  Runs f() on the same executor once the operation is finished
+             *  \param f function object called without arguments
+             *  \return \p future of the call
+             */
+            template<class F>
+            future then(const F& f) const
+            {
+                muse::detail::async_pool* pool = node ? node->pool : &executor::shared();
+                return future(muse::detail::async_spawn(pool, f, node));
+            }
+
+        private:
+            friend struct muse::detail::async_access;
+
+            explicit future(const muse::detail::async_node_ptr& n)
+                : node(n) {}
+
+            muse::detail::async_node_ptr node;
+
+        }; // end class future
+
+
+
+        /*!
+         *   Runs f() on the executor once after is finished
+         *
+         *   \param exec  executor to run on
+         *   \param f     function object called without arguments
+         *   \param after \p future to wait for
+         *   \return \p future of the call
+         */
+        template<class F>
+        future run(executor& exec, const F& f, const future& after = future());
+
+
+        /*!
+         *   Returns \p future finished once both a and b are finished
+         */
+        inline future when_all(const future& a, const future& b);
+
+
+        /*!
+         *   Returns \p future finished once all futures in [first, last) are finished
+         *   \param first beginning of range of futures
+         *   \param last  end of range of futures
+         */
+        template<class InputIterator>
+        future when_all(InputIterator first, InputIterator last);
+
+
+        /*!
+         *   Stable sort of all rows of a \p host_multiarray or \p device_multiarray
+         *   by K-th container, started once after is finished. The permutation
+         *   of rows is computed first, then every container is gathered.
+         *
+         *   Containers of a \p host_multiarray are gathered by separate tasks,
+         *   so idle workers steal them and the containers are processed in
+         *   parallel. Containers of a \p device_multiarray are processed by a
+         *   single task, each one by Thrust algorithms running in the device
+         *   system, in parallel when it is OMP or TBB.
+         *
+         *   The array must not be used by other threads until the returned
+         *   \p future is finished, except by operations depending on it.
+         *
+         *   \tparam K key container id
+         *
+         *   \param exec  executor to run on
+         *   \param array multiarray to sort
+         *   \param after \p future to wait for
+         *   \return \p future of the sort
+         *
+         *   The following code snippet demonstrates how to overlap independent
+         *   stages of a step
+         *
+         *   \code
+         *   #include <muse/multiarray.h>
+         *   #include <muse/multiarray/async.h>
+         *
+         *   muse::async::executor& exec = muse::async::executor::shared();
+         *
+         *   muse::host_multiarray<int, float> particles(1000000), hits(1000000), staged(1000000);
+         *   muse::device_multiarray<int, float> device;
+         *   thrust::host_vector<bool> alive(1000000);
+         *
+         *   // three independent graphs run at the same time
+         *   muse::async::future sorted = muse::async::sort_by_column<0>(exec, particles);
+         *   muse::async::future compacted = muse::async::compact(exec, hits, alive);
+         *   muse::async::future copied = muse::async::copy(exec, staged, device);
+         *
+         *   // runs once particles are sorted
+         *   muse::async::future merged = muse::async::copy(exec, particles, staged, muse::async::when_all(sorted, copied));
+         *
+         *   merged.wait();
+         *   compacted.wait();
+         *
+         *   \endcode
+         */
+        template<int K, class Array>
+        future sort_by_column(executor& exec, Array& array, const future& after = future());
+
+
+        /*!
+         *   Removes rows of a \p host_multiarray or \p device_multiarray whose
+         *   flag is not set, keeping order of the others, started once after
+         *   is finished. Containers are processed as by \p sort_by_column.
+         *
+         *   \param exec  executor to run on
+         *   \param array multiarray to compact
+         *   \param keep  one flag per row, \p thrust::host_vector<bool> for host
+         *               arrays and \p thrust::device_vector<bool> for device ones,
+         *               has to stay unchanged until the operation is finished.
+         *               Its size is asserted at submission when after is
+         *               ready, otherwise once the compaction starts.
+         *   \param after \p future to wait for
+         *   \return \p future of the compaction
+         */
+        template<class Array, class Flags>
+        future compact(executor& exec, Array& array, const Flags& keep, const future& after = future());
+
+
+        /*!
+         *   Copies all rows of src to dst, started once after is finished.
+         *   Both multiarrays have the same element types and may be in any
+         *   memory spaces, so this copies between host and device as well.
+         *   dst is resized first, then every container is copied by its own
+         *   task, a device destination by a single task.
+         *
+         *   \param exec  executor to run on
+         *   \param src   multiarray to copy, has to stay unchanged until the
+         *               operation is finished
+         *   \param dst   output multiarray
+         *   \param after \p future to wait for
+         *   \return \p future of the copy
+         */
+        template<class Src, class Dst>
+        future copy(executor& exec, const Src& src, Dst& dst, const future& after = future());
+
+
+    } // end namespace async
+
+
+
+    namespace detail
+    {
+
+        // Access to the graph node of a future
+        struct async_access
+        {
+            static muse::async::future make(const async_node_ptr& node) { return muse::async::future(node); }
+
+            static const async_node_ptr& node(const muse::async::future& f) { return f.node; }
+        };
+
+    } // end namespace detail
+
+
+
+    namespace async
+    {
+
+        template<class F>
+        future run(executor& exec, const F& f, const future& after)
+        {
+            using muse::detail::async_access;
+            return async_access::make(muse::detail::async_spawn(&exec, f, async_access::node(after)));
+        }
+
+
+        template<class InputIterator>
+        future when_all(InputIterator first, InputIterator last)
+        {
+            using muse::detail::async_access;
+
+            muse::detail::async_node_ptr join;
+            for (InputIterator i = first; i != last; ++i)
+            {
+                const muse::detail::async_node_ptr& dep = async_access::node(*i);
+                if (!dep || (dep->done && !dep->error))
+                {
+                    continue;
+                }
+                if (!join)
+                {
+                    join = muse::detail::async_make_node(dep->pool, muse::detail::async_no_work());
+                }
+                muse::detail::async_depend(join, dep);
+            }
+
+            if (!join)
+            {
+                return future();
+            }
+            muse::detail::async_release(join);
+            return async_access::make(join);
+        }
+
+
+        inline future when_all(const future& a, const future& b)
+        {
+            const future both[] = { a, b };
+            return when_all(both, both + 2);
+        }
+
+
+        template<int K, class Array>
+        future sort_by_column(executor& exec, Array& array, const future& after)
+        {
+            typedef muse::detail::async_sort<K, Array> columns_type;
+            using muse::detail::async_access;
+
+            columns_type columns = { &array, std::make_shared<typename columns_type::rows_type>() };
+            muse::detail::async_sort_keys<K, Array> head = { columns };
+
+            return async_access::make(
+                muse::detail::async_column_graph(&exec, async_access::node(after),
+                                                 head, columns, muse::detail::async_no_work()));
+        }
+
+
+        template<class Array, class Flags>
+        future compact(executor& exec, Array& array, const Flags& keep, const future& after)
+        {
+            typedef muse::detail::async_compact<Array, Flags> columns_type;
+            using muse::detail::async_access;
+
+            // Size is checked here unless a pending operation may still resize array
+            assert(!after.ready() || keep.size() == array.size());
+
+            columns_type columns = { &array, &keep, std::make_shared<std::size_t>(0) };
+            muse::detail::async_compact_count<Array, Flags> head = { columns };
+            muse::detail::async_compact_resize<Array, Flags> tail = { columns };
+
+            return async_access::make(
+                muse::detail::async_column_graph(&exec, async_access::node(after), head, columns, tail));
+        }
+
+
+        template<class Src, class Dst>
+        future copy(executor& exec, const Src& src, Dst& dst, const future& after)
+        {
+            typedef muse::detail::async_copy<Src, Dst> columns_type;
+            using muse::detail::async_access;
+
+            columns_type columns = { &src, &dst };
+            muse::detail::async_copy_resize<Src, Dst> head = { columns };
+
+            return async_access::make(
+                muse::detail::async_column_graph(&exec, async_access::node(after),
+                                                 head, columns, muse::detail::async_no_work()));
+        }
+
+
+    } // end namespace async
+
+
+} // end namespace muse
@@ -0,0 +1,223 @@
+/*! \file column_index.h
+ *  \brief Sorted secondary index on a container of host_multiarray.
+ */
+#pragma once
+
+#include <muse/multiarray/host_multiarray.h>
+#include <thrust/host_vector.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/binary_search.h>
+#include <algorithm>
+#include <utility>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Sorted secondary index on K-th container of a \p host_multiarray.
+     *   The index keeps a sorted copy of keys together with row ids, so range
+     *   and point lookups take O(log n) instead of a full scan.
+     *
+     *   Results of the lookups are positions in the sorted order; \p row
+     *   translates a position to a row id of the indexed multiarray.
+     *
+     *   The index remembers \p version of the indexed container. It goes stale
+     *   once the container is accessed through non-const \p get<K> or the
+     *   multiarray is resized, and every lookup rebuilds a stale index first.
+     *   Modifications bypassing \p get<K> are not detected.
+     *
+     *   \tparam K     indexed container id within the multiarray
+     *   \tparam Array indexed multiarray type
+     *
+     *   The following code snippet demonstrates how to use \p column_index
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/column_index.h>
+     *
+     *   typedef muse::host_multiarray<int, float> EventArray;
+     *
+     *   EventArray events(10000);
+     *
+     *   muse::column_index<0, EventArray> index(events);
+     *
+     *   // all rows with key in [10, 20)
+     *   std::pair<std::size_t, std::size_t> r = index.range(10, 20);
+     *
+     *   for (std::size_t i = r.first; i < r.second; ++i)
+     *   {
+     *       float energy = muse::get<1>(events)[index.row(i)];
+     *   }
+     *
+     *   \endcode
+     */
+    template<int K, class Array>
+    class column_index
+    {
+
+    public:
+        typedef typename multiarray_element<K, Array>::type container_type;
+        typedef typename container_type::value_type key_type;
+        typedef typename container_type::size_type size_type;
+        typedef std::pair<size_type, size_type> range_type;
+
+        /*!
+         *  This constructor builds index of K-th container of \p a
+         *  \param a indexed multiarray, it has to outlive the index
+         */
+        explicit column_index(const Array& a)
+            : array(&a), built_version(0), built(false) { rebuild(); }
+
+        /*!
+         *  This method returns true when the indexed container may have been
+         *  modified since the index was built
+         *  \return true if index has to be rebuilt; false, otherwise
+         */
+        bool stale(void) const
+        {
+            return !built || built_version != muse::version<K>(*array);
+        }
+
+        /*!
+         *  Rebuilds the index unconditionally
+         */
+        void rebuild(void)
+        {
+            const container_type& column = muse::get<K>(*array);
+
+            keys.assign(column.begin(), column.end());
+            rows.resize(column.size());
+            thrust::sequence(rows.begin(), rows.end());
+            thrust::stable_sort_by_key(keys.begin(), keys.end(), rows.begin());
+
+            built_version = muse::version<K>(*array);
+            built = true;
+        }
+
+        /*!
+         *  Rebuilds the index only when it is stale
+         */
+        void refresh(void) { if (stale()) rebuild(); }
+
+        /*!
+         *  Returns the number of indexed rows
+         *  \return number of indexed rows
+         */
+        size_type size(void) { refresh(); return keys.size(); }
+
+        /*!
+         *  Returns row id of the multiarray at position i of the sorted order
+         *  \param i position in the sorted order
+         *  \return row id
+         */
+        size_type row(size_type i) { refresh(); return rows[i]; }
+
+        /*!
+         *  Returns first position whose key is not less than key
+         *  \param key searched key
+         *  \return position in the sorted order
+         */
+        size_type lower_bound(const key_type& key)
+        {
+            refresh();
+            return std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        }
+
+        /*!
+         *  Returns first position whose key is greater than key
+         *  \param key searched key
+         *  \return position in the sorted order
+         */
+        size_type upper_bound(const key_type& key)
+        {
+            refresh();
+            return std::upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+        }
+
+        /*!
+         *  Returns positions of all rows whose key is equal to key
+         *  \param key searched key
+         *  \return half-open range of positions in the sorted order
+         */
+        range_type equal_range(const key_type& key)
+        {
+            return range_type(lower_bound(key), upper_bound(key));
+        }
+
+        /*!
+         *  Returns positions of all rows whose key is in [first, last)
+         *  \param first lower bound of keys, inclusive
+         *  \param last  upper bound of keys, exclusive
+         *  \return half-open range of positions in the sorted order
+         */
+        range_type range(const key_type& first, const key_type& last)
+        {
+            return range_type(lower_bound(first), lower_bound(last));
+        }
+
+        /*!
+         *  Batched \p lower_bound, runs all queries with a single vectorized search
+         *  \param queries searched keys
+         *  \param result  receives position for every query
+         */
+        template<class KeyVector, class PositionVector>
+        void lower_bound(const KeyVector& queries, PositionVector& result)
+        {
+            refresh();
+            result.resize(queries.size());
+            thrust::lower_bound(keys.begin(), keys.end(), queries.begin(), queries.end(), result.begin());
+        }
+
+        /*!
+         *  Batched \p upper_bound, runs all queries with a single vectorized search
+         *  \param queries searched keys
+         *  \param result  receives position for every query
+         */
+        template<class KeyVector, class PositionVector>
+        void upper_bound(const KeyVector& queries, PositionVector& result)
+        {
+            refresh();
+            result.resize(queries.size());
+            thrust::upper_bound(keys.begin(), keys.end(), queries.begin(), queries.end(), result.begin());
+        }
+
+        /*!
+         *  Batched \p equal_range
+         *  \param queries searched keys
+         *  \param first   receives first position of every query
+         *  \param last    receives end position of every query
+         */
+        template<class KeyVector, class PositionVector>
+        void equal_range(const KeyVector& queries, PositionVector& first, PositionVector& last)
+        {
+            lower_bound(queries, first);
+            upper_bound(queries, last);
+        }
+
+        /*!
+         *  Returns keys in the sorted order
+         *  \return const reference to sorted keys
+         */
+        const thrust::host_vector<key_type>& sorted_keys(void) { refresh(); return keys; }
+
+        /*!
+         *  Returns row ids in the sorted order
+         *  \return const reference to permutation sorting the indexed container
+         */
+        const thrust::host_vector<size_type>& sorted_rows(void) { refresh(); return rows; }
+
+    private:
+        const Array* array;
+        unsigned long built_version;
+        bool built;
+
+        thrust::host_vector<key_type> keys;
+        thrust::host_vector<size_type> rows;
+
+    }; // end class column_index
+
+
+} // end namespace muse
@@ -0,0 +1,96 @@
+/*! \file column_view.h
+ *  \brief Non-owning view of a contiguous range of elements, used by multiarray_view.
+ */
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Non-owning view of count contiguous elements in the "host" memory
+     *   space. Copying a view does not copy elements, constness of the view
+     *   does not propagate to elements, use a const element type for
+     *   read-only views.
+     *
+     *   Iterators are plain pointers, so Thrust algorithms dispatch to the
+     *   host backend.
+     *
+     *   \tparam T element type, may be const
+     *
+     *   \code
+     *   #include <muse/multiarray/column_view.h>
+     *   #include <thrust/sort.h>
+     *
+     *   float buffer[100];
+     *
+     *   muse::column_view<float> v(buffer, 100);
+     *
+     *   thrust::sort(v.begin(), v.end());
+     *
+     *   \endcode
+     */
+    template<typename T>
+    class column_view
+    {
+
+    public:
+        typedef typename std::remove_const<T>::type value_type;
+        typedef std::size_t size_type;
+        typedef T& reference;
+        typedef T& const_reference;
+        typedef T* pointer;
+        typedef T* iterator;
+        typedef T* const_iterator;
+
+        /*!
+         *  This constructor creates an empty \p column_view
+         */
+        column_view(void)
+            : first(0), n(0) {}
+
+        /*!
+         *  This constructor creates a \p column_view of count elements starting at data
+         *  \param data  first element
+         *  \param count number of elements
+         */
+        column_view(T* data, size_type count)
+            : first(data), n(count) {}
+
+        /*!
+         *  Views of non-const elements convert to views of const elements
+         */
+        template<typename U>
+        column_view(const column_view<U>& other)
+            : first(other.data()), n(other.size()) {}
+
+        size_type size(void) const { return n; }
+
+        bool empty(void) const { return 0 == n; }
+
+        pointer data(void) const { return first; }
+
+        reference operator[](size_type i) const { return first[i]; }
+
+        iterator begin(void) const { return first; }
+        iterator end(void) const { return first + n; }
+
+        /*!
+         *  Returns view of count elements starting at element offset
+         *  \param offset first element of the result
+         *  \param count  number of elements of the result
+         */
+        column_view subview(size_type offset, size_type count) const { return column_view(first + offset, count); }
+
+    private:
+        T* first;
+        size_type n;
+
+    }; // end class column_view
+
+
+} // end namespace muse
@@ -0,0 +1,94 @@
+/*! \file concatenate.h
+ *  \brief Concatenation and merging of multiarrays.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/concatenate.inl>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Concatenates multiarrays into one. The output is resized once to the
+     *   total number of elements, then every component is filled by its own
+     *   task, so components are copied in parallel. Outputs of fewer than
+     *   32768 rows are copied one component after another on the calling
+     *   thread. The output must not be one of the inputs.
+     *
+     *   \param first beginning of range of pointers to input multiarrays
+     *   \param last  end of range of pointers to input multiarrays
+     *   \param out   output multiarray
+     *
+     *   The following code snippet demonstrates how to use \p concatenate
+     *   to combine per-thread results
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/concatenate.h>
+     *
+     *   typedef muse::host_multiarray<int, float> ResultArray;
+     *
+     *   ResultArray a(100), b(200), c(300);
+     *   const ResultArray* parts[] = { &a, &b, &c };
+     *
+     *   ResultArray all;
+     *   muse::concatenate(parts, parts + 3, all);
+     *
+     *   \endcode
+     */
+    template<class InputIterator, class OutArray>
+    void concatenate(InputIterator first, InputIterator last, OutArray& out);
+
+
+    /*!
+     *   Concatenates multiarrays given as a braced list into one, the same
+     *   way as the iterator range version.
+     *
+     *   \param parts input multiarrays of the same type as out
+     *   \param out   output multiarray
+     *
+     *   \code
+     *   muse::host_multiarray<int, float> a(100), b(200), c(300), all;
+     *
+     *   muse::concatenate({a, b, c}, all);
+     *
+     *   \endcode
+     */
+    template<class OutArray>
+    void concatenate(std::initializer_list<typename muse::detail::concatenate_part<OutArray>::type> parts, OutArray& out);
+
+
+    /*!
+     *   Merges two multiarrays sorted by K-th component into one sorted
+     *   multiarray. Keys are merged with a single stable merge that also
+     *   yields the source row of every output element, the remaining
+     *   components are then gathered following it. Both steps are Thrust
+     *   algorithms running in the memory space of the output, so a
+     *   \p device_multiarray is merged on the device. Packed components are
+     *   written serially. Among equal keys elements of \p a come first.
+     *
+     *   \tparam K key component id
+     *
+     *   \param  a   first multiarray sorted by K-th component
+     *   \param  b   second multiarray sorted by K-th component
+     *   \param  out output multiarray, must not be \p a nor \p b
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/concatenate.h>
+     *
+     *   muse::host_multiarray<int, float> a(100), b(200), merged;
+     *
+     *   // a and b sorted by first component
+     *   muse::merge_by_column<0>(a, b, merged);
+     *
+     *   \endcode
+     */
+    template<int K, class Array, class OutArray>
+    void merge_by_column(const Array& a, const Array& b, OutArray& out);
+
+
+} // end namespace muse
@@ -0,0 +1,338 @@
+/*! \file arrow.inl
+ *  \brief Inline file for arrow.h.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/column_loop.inl>
+#include <muse/multiarray/encoding.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+/*
+ *   Apache Arrow C data interface, the definitions are part of the ABI
+ *   and have to match https://arrow.apache.org/docs/format/CDataInterface.html
+ */
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+
+namespace muse
+{
+
+
+    namespace detail
+    {
+
+        inline const char* arrow_integer_format(std::size_t size, bool is_signed)
+        {
+            switch (size)
+            {
+                case 1: return is_signed ? "c" : "C";
+                case 2: return is_signed ? "s" : "S";
+                case 4: return is_signed ? "i" : "I";
+                default: return is_signed ? "l" : "L";
+            }
+        }
+
+
+        // Arrow format string of element type T
+        template<typename T, bool Integral = std::is_integral<T>::value>
+        struct arrow_format;
+
+        template<typename T>
+        struct arrow_format<T, true>
+        {
+            static_assert(!std::is_same<typename std::remove_cv<T>::type, bool>::value,
+                          "Arrow booleans are bitmaps, use muse::packed_bool columns instead of bool");
+
+            static const char* value(void) { return arrow_integer_format(sizeof(T), std::is_signed<T>::value); }
+        };
+
+        template<>
+        struct arrow_format<float, false>
+        {
+            static const char* value(void) { return "f"; }
+        };
+
+        template<>
+        struct arrow_format<double, false>
+        {
+            static const char* value(void) { return "g"; }
+        };
+
+        // Non-null data pointer of empty containers
+        inline const void* arrow_empty_buffer(void)
+        {
+            static const muse::packed_word zero = 0;
+            return &zero;
+        }
+
+
+        // Format and data buffer of a container
+        template<class Container>
+        struct arrow_column
+        {
+            static const char* format(void)
+            {
+                return arrow_format<typename Container::value_type>::value();
+            }
+
+            static const void* data(const Container& c)
+            {
+                return c.empty() ? arrow_empty_buffer() : static_cast<const void*>(&c[0]);
+            }
+        };
+
+        // Bit order of packed words matches Arrow bitmaps on little-endian hosts
+        template<>
+        struct arrow_column<muse::bit_vector>
+        {
+            static const char* format(void) { return "b"; }
+
+            static const void* data(const muse::bit_vector& c) { return &c.words()[0]; }
+        };
+
+
+
+        /*
+         *   Storage of exported structures. Every exported ArrowSchema and
+         *   ArrowArray, children included, holds its own reference, so children
+         *   moved out by the consumer stay valid after their parent is released.
+         */
+        struct arrow_export
+        {
+            std::vector<ArrowSchema> schemas;
+            std::vector<ArrowSchema*> schema_children;
+            std::vector<std::string> names;
+
+            std::vector<ArrowArray> arrays;
+            std::vector<ArrowArray*> array_children;
+            std::vector<const void*> buffers;
+
+            virtual ~arrow_export(void) {}
+        };
+
+        // Keeps exported containers alive
+        template<class Snapshot>
+        struct arrow_export_snapshot : public arrow_export
+        {
+            explicit arrow_export_snapshot(const Snapshot& s)
+                : snapshot(s) {}
+
+            Snapshot snapshot;
+        };
+
+        typedef std::shared_ptr<arrow_export> arrow_export_handle;
+
+
+        // Release callback of exported ArrowSchema and ArrowArray
+        template<class S>
+        void release_arrow(S* s)
+        {
+            for (int64_t i = 0; i < s->n_children; ++i)
+            {
+                if (s->children[i]->release)
+                {
+                    s->children[i]->release(s->children[i]);
+                }
+            }
+            delete static_cast<arrow_export_handle*>(s->private_data);
+            s->release = 0;
+        }
+
+
+        // Fills child schema and array of every container
+        struct arrow_export_columns
+        {
+            arrow_export* e;
+
+            template<class Container>
+            void operator()(const Container& c, int i)
+            {
+                ArrowSchema& s = e->schemas[i];
+                s.format = arrow_column<Container>::format();
+                s.metadata = 0;
+                s.flags = 0;
+                s.n_children = 0;
+                s.children = 0;
+                s.dictionary = 0;
+
+                e->buffers[1 + 2 * i] = 0;
+                e->buffers[2 + 2 * i] = arrow_column<Container>::data(c);
+
+                ArrowArray& a = e->arrays[i];
+                a.length = static_cast<int64_t>(c.size());
+                a.null_count = 0;
+                a.offset = 0;
+                a.n_buffers = 2;
+                a.n_children = 0;
+                a.buffers = &e->buffers[1 + 2 * i];
+                a.children = 0;
+                a.dictionary = 0;
+            }
+        };
+
+
+        template<class Snapshot>
+        void export_arrow_snapshot(const Snapshot& snapshot, const char* const* names,
+                                   ArrowSchema* schema, ArrowArray* array)
+        {
+            const int columns = multiarray_size<Snapshot>::value;
+
+            arrow_export_snapshot<Snapshot>* e = new arrow_export_snapshot<Snapshot>(snapshot);
+            const arrow_export_handle handle(e);
+
+            e->schemas.resize(columns);
+            e->schema_children.resize(columns);
+            e->names.resize(columns);
+            e->arrays.resize(columns);
+            e->array_children.resize(columns);
+            e->buffers.resize(1 + 2 * columns);
+
+            arrow_export_columns f = { e };
+            for_each_column(f, e->snapshot);
+
+            for (int i = 0; i < columns; ++i)
+            {
+                e->names[i] = names ? std::string(names[i]) : std::to_string(i);
+                e->schemas[i].name = e->names[i].c_str();
+                e->schemas[i].release = &release_arrow<ArrowSchema>;
+                e->schemas[i].private_data = new arrow_export_handle(handle);
+                e->schema_children[i] = &e->schemas[i];
+
+                e->arrays[i].release = &release_arrow<ArrowArray>;
+                e->arrays[i].private_data = new arrow_export_handle(handle);
+                e->array_children[i] = &e->arrays[i];
+            }
+            e->buffers[0] = 0;
+
+            schema->format = "+s";
+            schema->name = "";
+            schema->metadata = 0;
+            schema->flags = 0;
+            schema->n_children = columns;
+            schema->children = &e->schema_children[0];
+            schema->dictionary = 0;
+            schema->release = &release_arrow<ArrowSchema>;
+            schema->private_data = new arrow_export_handle(handle);
+
+            array->length = static_cast<int64_t>(e->snapshot.size());
+            array->null_count = 0;
+            array->offset = 0;
+            array->n_buffers = 1;
+            array->n_children = columns;
+            array->buffers = &e->buffers[0];
+            array->children = &e->array_children[0];
+            array->dictionary = 0;
+            array->release = &release_arrow<ArrowArray>;
+            array->private_data = new arrow_export_handle(handle);
+        }
+
+
+
+        /*
+         *   Points N-th view at N-th child array, rows [offset, offset + length)
+         *   of the parent struct array. Child length excludes its own offset, so
+         *   it has to cover the parent range. Fails on type, null, length or
+         *   alignment mismatch.
+         */
+        template<int N, int Size>
+        struct import_arrow_loop
+        {
+            template<class View>
+            static bool apply(const ArrowSchema* schema, const ArrowArray* array, View& view)
+            {
+                typedef typename multiarray_element<N, View>::type view_type;
+                typedef typename view_type::value_type value_type;
+                typedef typename view_type::pointer pointer;
+
+                static_assert(std::is_const<typename std::remove_pointer<pointer>::type>::value,
+                              "Arrow buffers are immutable, view element types have to be const");
+
+                const ArrowSchema* s = schema->children[N];
+                const ArrowArray* a = array->children[N];
+
+                if (0 != std::strcmp(s->format, arrow_format<value_type>::value())
+                    || a->n_buffers != 2
+                    || (a->null_count != 0 && a->buffers[0] != 0)
+                    || array->offset + array->length > a->length)
+                {
+                    return false;
+                }
+
+                pointer data = static_cast<pointer>(a->buffers[1]);
+                if (0 == data)
+                {
+                    data = static_cast<pointer>(arrow_empty_buffer());
+                }
+                data += a->offset + array->offset;
+
+                if (0 != reinterpret_cast<std::uintptr_t>(data) % alignof(value_type))
+                {
+                    return false;
+                }
+
+                view.template get<N>() = view_type(data, static_cast<std::size_t>(array->length));
+
+                return import_arrow_loop<N+1, Size>::apply(schema, array, view);
+            }
+        };
+
+        template<int Size>
+        struct import_arrow_loop<Size, Size>
+        {
+            template<class View>
+            static bool apply(const ArrowSchema*, const ArrowArray*, View&) { return true; }
+        };
+
+    } // end namespace detail
+
+
+} // end namespace muse
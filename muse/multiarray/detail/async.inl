@@ -0,0 +1,655 @@
+/*! \file async.inl
+ *  \brief Inline file for async.h.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <muse/multiarray/encoding.h>
+#include <thrust/host_vector.h>
+#include <thrust/device_vector.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/gather.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/functional.h>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace muse
+{
+
+
+    namespace detail
+    {
+
+        class async_pool;
+
+
+        /*
+         *   Node of a dependency graph. It is queued on its pool once all nodes
+         *   it depends on are finished, then runs its work and releases its
+         *   dependants. pending counts unfinished dependencies plus one, held
+         *   by the builder of the graph until all dependencies are registered.
+         *   A node whose dependency failed skips its work and fails as well.
+         */
+        struct async_node
+        {
+            explicit async_node(async_pool* p)
+                : pool(p), pending(1), done(false) {}
+
+            async_pool* pool;
+            std::function<void(void)> work;
+
+            std::atomic<int> pending;
+            std::atomic<bool> done;
+
+            // Exception of the work or of a failed dependency, set before done
+            std::exception_ptr error;
+
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::vector<std::shared_ptr<async_node> > dependants;
+        };
+
+        typedef std::shared_ptr<async_node> async_node_ptr;
+
+
+        // Pool and queue the calling thread works for, none for other threads
+        struct async_worker
+        {
+            async_pool* pool;
+            std::size_t index;
+        };
+
+        inline async_worker& async_current_worker(void)
+        {
+            static thread_local async_worker worker = { 0, 0 };
+            return worker;
+        }
+
+
+        inline void async_run(const async_node_ptr& node);
+
+
+        /*
+         *   Work-stealing thread pool. Every worker has its own deque, nodes
+         *   queued by a worker go to its own deque, others are spread round
+         *   robin. A worker takes the newest node of its own deque, so a chain
+         *   of dependants stays on one core, and when it runs dry it steals
+         *   the oldest node of another deque.
+         */
+        class async_pool
+        {
+        public:
+            explicit async_pool(std::size_t threads)
+                : queued(0), next(0), stopping(false)
+            {
+                threads = threads > 0 ? threads : 1;
+                for (std::size_t i = 0; i < threads; ++i)
+                {
+                    queues.push_back(std::unique_ptr<queue>(new queue));
+                }
+                for (std::size_t i = 0; i < threads; ++i)
+                {
+                    workers.push_back(std::thread(&async_pool::work, this, i));
+                }
+            }
+
+            ~async_pool(void)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(sleep_mutex);
+                    stopping = true;
+                }
+                wake.notify_all();
+                for (std::size_t i = 0; i < workers.size(); ++i)
+                {
+                    workers[i].join();
+                }
+            }
+
+            std::size_t thread_count(void) const { return workers.size(); }
+
+            void push(const async_node_ptr& node)
+            {
+                const async_worker& self = async_current_worker();
+                const std::size_t index = self.pool == this ? self.index : next++ % queues.size();
+
+                ++queued;
+                {
+                    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+                    queues[index]->tasks.push_back(node);
+                }
+
+                // Taking the lock orders the wake up after a sleeping worker checked queued
+                {
+                    std::lock_guard<std::mutex> lock(sleep_mutex);
+                }
+                wake.notify_one();
+            }
+
+            // Runs one queued node on behalf of worker index, false when there is none
+            bool run_one(std::size_t index)
+            {
+                async_node_ptr node;
+                if (!pop(index, node))
+                {
+                    return false;
+                }
+                async_run(node);
+                return true;
+            }
+
+            // Blocks until node is finished, workers of this pool must not wait on it
+            void wait(async_node& node)
+            {
+                // A waiting worker could hold up the very nodes it waits for
+                assert(async_current_worker().pool != this);
+
+                std::unique_lock<std::mutex> lock(node.mutex);
+                while (!node.done)
+                {
+                    node.finished.wait(lock);
+                }
+            }
+
+        private:
+            async_pool(const async_pool&);
+            async_pool& operator=(const async_pool&);
+
+            struct queue
+            {
+                std::mutex mutex;
+                std::deque<async_node_ptr> tasks;
+            };
+
+            bool pop(std::size_t index, async_node_ptr& node)
+            {
+                const std::size_t n = queues.size();
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    queue& q = *queues[(index + i) % n];
+                    std::lock_guard<std::mutex> lock(q.mutex);
+                    if (!q.tasks.empty())
+                    {
+                        // Own deque from the back, stolen work from the front
+                        if (0 == i)
+                        {
+                            node = q.tasks.back();
+                            q.tasks.pop_back();
+                        }
+                        else
+                        {
+                            node = q.tasks.front();
+                            q.tasks.pop_front();
+                        }
+                        --queued;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void work(std::size_t index)
+            {
+                async_worker& self = async_current_worker();
+                self.pool = this;
+                self.index = index;
+
+                for (;;)
+                {
+                    if (run_one(index))
+                    {
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(sleep_mutex);
+                    while (!stopping && 0 == queued)
+                    {
+                        wake.wait(lock);
+                    }
+                    if (stopping && 0 == queued)
+                    {
+                        return;
+                    }
+                }
+            }
+
+            std::vector<std::unique_ptr<queue> > queues;
+            std::vector<std::thread> workers;
+
+            std::atomic<long> queued;
+            std::atomic<std::size_t> next;
+
+            std::mutex sleep_mutex;
+            std::condition_variable wake;
+            bool stopping;
+        };
+
+
+
+        template<class F>
+        inline async_node_ptr async_make_node(async_pool* pool, const F& work)
+        {
+            async_node_ptr node = std::make_shared<async_node>(pool);
+            node->work = work;
+            return node;
+        }
+
+        // Records failure of a dependency of node, the first one wins
+        inline void async_fail(const async_node_ptr& node, const std::exception_ptr& error)
+        {
+            std::lock_guard<std::mutex> lock(node->mutex);
+            if (!node->error)
+            {
+                node->error = error;
+            }
+        }
+
+        // Makes node wait for dep, finished and empty dependencies are skipped, failed ones fail node
+        inline void async_depend(const async_node_ptr& node, const async_node_ptr& dep)
+        {
+            if (!dep)
+            {
+                return;
+            }
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(dep->mutex);
+                if (!dep->done)
+                {
+                    ++node->pending;
+                    dep->dependants.push_back(node);
+                }
+                error = dep->error;
+            }
+            if (error)
+            {
+                async_fail(node, error);
+            }
+        }
+
+        // Drops one pending dependency, the last one queues the node
+        inline void async_release(const async_node_ptr& node)
+        {
+            if (1 == node->pending--)
+            {
+                node->pool->push(node);
+            }
+        }
+
+        inline void async_run(const async_node_ptr& node)
+        {
+            // Exceptions are kept for wait, a worker thread must not be left by one
+            if (node->work && !node->error)
+            {
+                try
+                {
+                    node->work();
+                }
+                catch (...)
+                {
+                    node->error = std::current_exception();
+                }
+            }
+            // Frees state captured by the work as soon as it is done
+            node->work = std::function<void(void)>();
+
+            std::vector<async_node_ptr> ready;
+            {
+                std::lock_guard<std::mutex> lock(node->mutex);
+                node->done = true;
+                ready.swap(node->dependants);
+            }
+            node->finished.notify_all();
+
+            for (std::size_t i = 0; i < ready.size(); ++i)
+            {
+                if (node->error)
+                {
+                    async_fail(ready[i], node->error);
+                }
+                async_release(ready[i]);
+            }
+        }
+
+        // Queues work once after is finished
+        template<class F>
+        inline async_node_ptr async_spawn(async_pool* pool, const F& work, const async_node_ptr& after)
+        {
+            async_node_ptr node = async_make_node(pool, work);
+            async_depend(node, after);
+            async_release(node);
+            return node;
+        }
+
+
+
+        /*
+         *   Temporary vector of element type U in the memory space of a
+         *   container. Algorithms on device containers run in the Thrust
+         *   device system, so in parallel when it is OMP or TBB.
+         */
+        template<class Container, typename U>
+        struct async_vector
+        {
+            typedef thrust::host_vector<U> type;
+            static const bool device = false;
+        };
+
+        template<typename T, typename Alloc, typename U>
+        struct async_vector<thrust::device_vector<T, Alloc>, U>
+        {
+            typedef thrust::device_vector<U> type;
+            static const bool device = true;
+        };
+
+
+        // Moves values of tmp into container c, resizing it to tmp.size() where possible
+        template<class Vector>
+        inline void async_assign(Vector& c, Vector& tmp)
+        {
+            c.swap(tmp);
+        }
+
+        template<typename T>
+        inline void async_assign(muse::for_vector<T>& c, thrust::host_vector<T>& tmp)
+        {
+            c.assign(tmp.begin(), tmp.end());
+        }
+
+        // Other containers, e.g. bit-packed ones, keep their size until the multiarray is resized
+        template<class Container, class Vector>
+        inline void async_assign(Container& c, Vector& tmp)
+        {
+            copy_elements(tmp.begin(), tmp.end(), c.begin());
+        }
+
+
+        struct async_no_work
+        {
+            void operator()(void) {}
+        };
+
+
+        // Runs column tasks of a graph one after another, for device arrays
+        template<int N, int Size>
+        struct async_column_loop
+        {
+            template<class Columns>
+            static void apply(const Columns& columns)
+            {
+                typename Columns::template column<N>::type task = { columns };
+                task();
+                async_column_loop<N+1, Size>::apply(columns);
+            }
+
+            // One node per column task, each waits for head and is waited for by tail
+            template<class Columns>
+            static void spawn(async_pool* pool, const Columns& columns,
+                              const async_node_ptr& head, const async_node_ptr& tail)
+            {
+                typename Columns::template column<N>::type task = { columns };
+                async_node_ptr node = async_make_node(pool, task);
+                async_depend(node, head);
+                async_depend(tail, node);
+                async_release(node);
+                async_column_loop<N+1, Size>::spawn(pool, columns, head, tail);
+            }
+        };
+
+        template<int Size>
+        struct async_column_loop<Size, Size>
+        {
+            template<class Columns>
+            static void apply(const Columns&) {}
+
+            template<class Columns>
+            static void spawn(async_pool*, const Columns&, const async_node_ptr&, const async_node_ptr&) {}
+        };
+
+        template<class Columns>
+        struct async_serial_columns
+        {
+            Columns columns;
+
+            void operator()(void)
+            {
+                async_column_loop<0, multiarray_size<typename Columns::array_type>::value>::apply(columns);
+            }
+        };
+
+
+        /*
+         *   Graph of a multiarray operation: head runs after after, then a task
+         *   per column, then tail. Column tasks of host arrays are separate
+         *   nodes stolen by idle workers. Those of device arrays run in a single
+         *   node, Thrust parallelizes each of them in the device system.
+         */
+        template<class Head, class Columns, class Tail>
+        async_node_ptr async_column_graph(async_pool* pool, const async_node_ptr& after,
+                                          const Head& head_work, const Columns& columns, const Tail& tail_work)
+        {
+            typedef typename Columns::array_type array_type;
+            typedef typename multiarray_element<0, array_type>::type container_type;
+
+            async_node_ptr head = async_make_node(pool, head_work);
+            async_node_ptr tail = async_make_node(pool, tail_work);
+            async_depend(head, after);
+
+            if (async_vector<container_type, char>::device)
+            {
+                async_serial_columns<Columns> serial = { columns };
+                async_node_ptr node = async_make_node(pool, serial);
+                async_depend(node, head);
+                async_depend(tail, node);
+                async_release(node);
+            }
+            else
+            {
+                async_column_loop<0, multiarray_size<array_type>::value>::spawn(pool, columns, head, tail);
+            }
+
+            async_release(tail);
+            async_release(head);
+            return tail;
+        }
+
+
+
+        template<int N, int K, class Array> struct async_sort_column;
+        template<int N, class Array, class Flags> struct async_compact_column;
+        template<int N, class Src, class Dst> struct async_copy_column;
+
+
+        /*
+         *   Stable sort of all columns by K-th one: the head computes the
+         *   permutation of rows, every column is then gathered by its own task.
+         */
+        template<int K, class Array>
+        struct async_sort
+        {
+            typedef Array array_type;
+            typedef typename multiarray_element<K, Array>::type key_container;
+            typedef typename async_vector<key_container, std::size_t>::type rows_type;
+
+            template<int N>
+            struct column
+            {
+                typedef async_sort_column<N, K, Array> type;
+            };
+
+            Array* array;
+            std::shared_ptr<rows_type> rows;
+        };
+
+        template<int K, class Array>
+        struct async_sort_keys
+        {
+            typedef typename async_sort<K, Array>::key_container key_container;
+            typedef typename async_vector<key_container, typename key_container::value_type>::type keys_type;
+
+            async_sort<K, Array> columns;
+
+            void operator()(void)
+            {
+                MUSE_SCOPED_TIMER("async::sort_by_column");
+
+                const Array& a = *columns.array;
+                const key_container& keys = a.template get<K>();
+                keys_type sorted(keys.begin(), keys.end());
+
+                columns.rows->resize(sorted.size());
+                thrust::sequence(columns.rows->begin(), columns.rows->end());
+                thrust::stable_sort_by_key(sorted.begin(), sorted.end(), columns.rows->begin());
+            }
+        };
+
+        template<int N, int K, class Array>
+        struct async_sort_column
+        {
+            typedef typename multiarray_element<N, Array>::type container_type;
+            typedef typename container_type::value_type value_type;
+
+            async_sort<K, Array> columns;
+
+            void operator()(void)
+            {
+                const typename async_sort<K, Array>::rows_type& rows = *columns.rows;
+                container_type& c = columns.array->template get<N>();
+
+                typename async_vector<container_type, value_type>::type tmp(rows.size());
+                thrust::gather(rows.begin(), rows.end(), c.begin(), tmp.begin());
+                async_assign(c, tmp);
+                record_bytes_moved(rows.size() * sizeof(value_type));
+            }
+        };
+
+
+
+        /*
+         *   Removal of rows whose flag is not set: the head counts kept rows,
+         *   every column is compacted by its own task, the tail resizes the array.
+         */
+        template<class Array, class Flags>
+        struct async_compact
+        {
+            typedef Array array_type;
+
+            template<int N>
+            struct column
+            {
+                typedef async_compact_column<N, Array, Flags> type;
+            };
+
+            Array* array;
+            const Flags* keep;
+            std::shared_ptr<std::size_t> kept;
+        };
+
+        template<class Array, class Flags>
+        struct async_compact_count
+        {
+            async_compact<Array, Flags> columns;
+
+            void operator()(void)
+            {
+                MUSE_SCOPED_TIMER("async::compact");
+                assert(columns.keep->size() == columns.array->size());
+                *columns.kept = thrust::count(columns.keep->begin(), columns.keep->end(), true);
+            }
+        };
+
+        template<int N, class Array, class Flags>
+        struct async_compact_column
+        {
+            typedef typename multiarray_element<N, Array>::type container_type;
+            typedef typename container_type::value_type value_type;
+
+            async_compact<Array, Flags> columns;
+
+            void operator()(void)
+            {
+                const Flags& keep = *columns.keep;
+                container_type& c = columns.array->template get<N>();
+
+                typename async_vector<container_type, value_type>::type tmp(*columns.kept);
+                thrust::copy_if(c.begin(), c.begin() + keep.size(), keep.begin(), tmp.begin(), thrust::identity<bool>());
+                async_assign(c, tmp);
+                record_bytes_moved(*columns.kept * sizeof(value_type));
+            }
+        };
+
+        template<class Array, class Flags>
+        struct async_compact_resize
+        {
+            async_compact<Array, Flags> columns;
+
+            void operator()(void) { columns.array->resize(*columns.kept); }
+        };
+
+
+
+        /*
+         *   Copy of all rows between multiarrays of the same element types in
+         *   any memory spaces: the head resizes dst, every column is copied by
+         *   its own task.
+         */
+        template<class Src, class Dst>
+        struct async_copy
+        {
+            typedef Dst array_type;
+
+            template<int N>
+            struct column
+            {
+                typedef async_copy_column<N, Src, Dst> type;
+            };
+
+            const Src* src;
+            Dst* dst;
+        };
+
+        template<class Src, class Dst>
+        struct async_copy_resize
+        {
+            async_copy<Src, Dst> columns;
+
+            void operator()(void)
+            {
+                MUSE_SCOPED_TIMER("async::copy");
+                columns.dst->resize(columns.src->size());
+            }
+        };
+
+        template<int N, class Src, class Dst>
+        struct async_copy_column
+        {
+            typedef typename multiarray_element<N, Dst>::type::value_type value_type;
+
+            async_copy<Src, Dst> columns;
+
+            void operator()(void)
+            {
+                copy_elements(columns.src->template get<N>().begin(),
+                              columns.src->template get<N>().end(),
+                              columns.dst->template get<N>().begin());
+                record_bytes_moved(columns.src->size() * sizeof(value_type));
+            }
+        };
+
+    } // end namespace detail
+
+
+} // end namespace muse
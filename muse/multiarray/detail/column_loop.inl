@@ -0,0 +1,97 @@
+/*! \file column_loop.inl
+ *  \brief Compile-time loops over the containers of host_multiarray and device_multiarray.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+
+namespace muse
+{
+
+    namespace detail
+    {
+
+        /*
+         *   Applies functor f to every container of a multiarray, in order.
+         *   The functor is called as f(container, column_id).
+         *   Works for any multiarray whose containers are accessible through
+         *   member get<N>.
+         */
+        template<int N, int Size>
+        struct column_loop
+        {
+
+            template<class F, class C>
+            inline static void apply(F& f, C& c)
+            {
+                f(c.template get<N>(), N);
+                column_loop<N+1, Size>::apply(f, c);
+            }
+
+            template<class F, class C>
+            inline static void apply(F& f, const C& c)
+            {
+                f(c.template get<N>(), N);
+                column_loop<N+1, Size>::apply(f, c);
+            }
+
+        };
+
+        template<int Size>
+        struct column_loop<Size, Size>
+        {
+
+            template<class F, class C>
+            inline static void apply(F&, C&) {}
+
+            template<class F, class C>
+            inline static void apply(F&, const C&) {}
+
+        };
+
+
+
+        /*
+         *   Applies functor f to every pair of containers of two multiarrays.
+         *   N-th container of src is paired with (Offset + N)-th container of dst.
+         *   The functor is called as f(src_container, dst_container).
+         */
+        template<int N, int Size, int Offset>
+        struct column_pair_loop
+        {
+
+            template<class F, class S, class D>
+            inline static void apply(F& f, S& src, D& dst)
+            {
+                f(src.template get<N>(), dst.template get<Offset + N>());
+                column_pair_loop<N+1, Size, Offset>::apply(f, src, dst);
+            }
+
+        };
+
+        template<int Size, int Offset>
+        struct column_pair_loop<Size, Size, Offset>
+        {
+
+            template<class F, class S, class D>
+            inline static void apply(F&, S&, D&) {}
+
+        };
+
+
+
+        template<class F, class C>
+        inline void for_each_column(F& f, C& c)
+        {
+            column_loop<0, multiarray_size<C>::value>::apply(f, c);
+        }
+
+        template<int Offset, class F, class S, class D>
+        inline void for_each_column_pair(F& f, S& src, D& dst)
+        {
+            column_pair_loop<0, multiarray_size<S>::value, Offset>::apply(f, src, dst);
+        }
+
+    } // end namespace detail
+
+} // end namespace muse
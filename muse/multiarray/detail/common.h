@@ -58,6 +58,13 @@ namespace muse
 
 
 
+    template<class T> struct multiarray_size<const T>
+    {
+        static const int value = multiarray_size<T>::value;
+    };
+
+
+
     // define null_type
     struct null_type {};
 
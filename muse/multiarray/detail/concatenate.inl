@@ -0,0 +1,375 @@
+/*! \file concatenate.inl
+ *  \brief Inline file for concatenate.h.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <muse/multiarray/encoding.h>
+#include <thrust/copy.h>
+#include <thrust/merge.h>
+#include <thrust/gather.h>
+#include <thrust/host_vector.h>
+#include <thrust/device_vector.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace muse
+{
+
+
+    namespace detail
+    {
+        // Input of concatenate given as a braced list of multiarrays
+        template<class Array>
+        struct concatenate_part
+        {
+            typedef std::reference_wrapper<const Array> type;
+        };
+    } // end namespace detail
+
+
+    /*!
+     *   Forward declaration of concatenate function
+     */
+    template<class InputIterator, class OutArray>
+    void concatenate(InputIterator first, InputIterator last, OutArray& out);
+
+    template<class OutArray>
+    void concatenate(std::initializer_list<typename muse::detail::concatenate_part<OutArray>::type> parts, OutArray& out);
+
+    /*!
+     *   Forward declaration of merge_by_column function
+     */
+    template<int K, class Array, class OutArray>
+    void merge_by_column(const Array& a, const Array& b, OutArray& out);
+
+
+
+    namespace detail
+    {
+
+        /*
+         *   Copies count rows of every container of src to dst starting at row
+         *   offset. apply copies every container by its own OpenMP task, so the
+         *   containers are copied in parallel and a single container is never
+         *   written by two threads (packed containers share words between rows).
+         *   apply_serial copies them one after another on the calling thread.
+         */
+        template<int N, int Size>
+        struct copy_rows_loop
+        {
+            template<class Src, class Dst>
+            static void copy(const Src* src, Dst* dst, std::size_t offset, std::size_t count)
+            {
+                copy_elements(src->template get<N>().begin(),
+                              src->template get<N>().begin() + count,
+                              dst->template get<N>().begin() + offset);
+                record_bytes_moved(rows_footprint(dst->template get<N>(), count));
+            }
+
+            template<class Src, class Dst>
+            static void apply(const Src* src, Dst* dst, std::size_t offset, std::size_t count)
+            {
+#ifdef _OPENMP
+#pragma omp task firstprivate(src, dst, offset, count)
+#endif
+                copy(src, dst, offset, count);
+
+                copy_rows_loop<N+1, Size>::apply(src, dst, offset, count);
+            }
+
+            template<class Src, class Dst>
+            static void apply_serial(const Src* src, Dst* dst, std::size_t offset, std::size_t count)
+            {
+                copy(src, dst, offset, count);
+                copy_rows_loop<N+1, Size>::apply_serial(src, dst, offset, count);
+            }
+        };
+
+        template<int Size>
+        struct copy_rows_loop<Size, Size>
+        {
+            template<class Src, class Dst>
+            static void apply(const Src*, Dst*, std::size_t, std::size_t) {}
+
+            template<class Src, class Dst>
+            static void apply_serial(const Src*, Dst*, std::size_t, std::size_t) {}
+        };
+
+
+        // Rows below which copying containers one after another is cheaper than starting OpenMP threads
+        static const std::size_t parallel_copy_rows = 32768;
+
+
+        // Copies containers in parallel once there are enough rows to pay for it
+        template<class Src, class Dst>
+        void copy_rows(const Src& src, Dst& dst, std::size_t offset, std::size_t count)
+        {
+#ifdef _OPENMP
+            if (count >= parallel_copy_rows)
+            {
+#pragma omp parallel
+#pragma omp single
+                copy_rows_loop<0, multiarray_size<Src>::value>::apply(&src, &dst, offset, count);
+                return;
+            }
+#endif
+            copy_rows_loop<0, multiarray_size<Src>::value>::apply_serial(&src, &dst, offset, count);
+        }
+
+
+        // Appends all rows of src to dst with a single resize of dst
+        template<class Dst, class Src>
+        void append_rows(Dst& dst, const Src& src)
+        {
+            const std::size_t offset = dst.size();
+            const std::size_t count = src.size();
+            dst.resize(offset + count);
+            copy_rows(src, dst, offset, count);
+        }
+
+
+        // Same as append_rows, always on the calling thread
+        template<class Dst, class Src>
+        void append_rows_serial(Dst& dst, const Src& src)
+        {
+            const std::size_t offset = dst.size();
+            const std::size_t count = src.size();
+            dst.resize(offset + count);
+            copy_rows_loop<0, multiarray_size<Src>::value>::apply_serial(&src, &dst, offset, count);
+        }
+
+
+        /*
+         *   Same as copy_rows_loop, every task copies one container of all
+         *   multiarrays in [first, last) one after another
+         */
+        template<int N, int Size>
+        struct concatenate_loop
+        {
+            template<class InputIterator, class OutArray>
+            static void copy(InputIterator first, InputIterator last, OutArray* out)
+            {
+                std::size_t offset = 0;
+                for (InputIterator i = first; i != last; ++i)
+                {
+                    copy_elements((*i)->template get<N>().begin(),
+                                  (*i)->template get<N>().end(),
+                                  out->template get<N>().begin() + offset);
+                    offset += (*i)->size();
+                }
+                record_bytes_moved(rows_footprint(out->template get<N>(), offset));
+            }
+
+            template<class InputIterator, class OutArray>
+            static void apply(InputIterator first, InputIterator last, OutArray* out)
+            {
+#ifdef _OPENMP
+#pragma omp task firstprivate(first, last, out)
+#endif
+                copy(first, last, out);
+
+                concatenate_loop<N+1, Size>::apply(first, last, out);
+            }
+
+            template<class InputIterator, class OutArray>
+            static void apply_serial(InputIterator first, InputIterator last, OutArray* out)
+            {
+                copy(first, last, out);
+                concatenate_loop<N+1, Size>::apply_serial(first, last, out);
+            }
+        };
+
+        template<int Size>
+        struct concatenate_loop<Size, Size>
+        {
+            template<class InputIterator, class OutArray>
+            static void apply(InputIterator, InputIterator, OutArray*) {}
+
+            template<class InputIterator, class OutArray>
+            static void apply_serial(InputIterator, InputIterator, OutArray*) {}
+        };
+
+
+        // Vector of row ids in the memory space of a container
+        template<class Container>
+        struct row_vector
+        {
+            typedef thrust::host_vector<std::size_t> type;
+        };
+
+        template<typename T, typename Alloc>
+        struct row_vector<thrust::device_vector<T, Alloc> >
+        {
+            typedef thrust::device_vector<std::size_t> type;
+        };
+
+
+        // Merged rows taken from the first input, source ids below na
+        struct merge_from_first
+        {
+            std::size_t na;
+
+            bool operator()(std::size_t s) const { return s < na; }
+        };
+
+        struct merge_from_second
+        {
+            std::size_t na;
+
+            bool operator()(std::size_t s) const { return !(s < na); }
+        };
+
+        struct merge_second_row
+        {
+            std::size_t na;
+
+            std::size_t operator()(std::size_t s) const { return s - na; }
+        };
+
+
+        template<class Src, class Dst, class Rows>
+        void merge_gather(const Src& a, const Src& b, Dst& dst, const Rows& source, std::size_t na)
+        {
+            const merge_from_first from_a = { na };
+            const merge_from_second from_b = { na };
+            const merge_second_row row_b = { na };
+
+            thrust::gather_if(source.begin(), source.end(), source.begin(), a.begin(), dst.begin(), from_a);
+            thrust::gather_if(thrust::make_transform_iterator(source.begin(), row_b),
+                              thrust::make_transform_iterator(source.end(), row_b),
+                              source.begin(), b.begin(), dst.begin(), from_b);
+        }
+
+
+        /*
+         *   Copies rows of a and b to a container of out following the merged
+         *   order. source[i] < na selects row source[i] of a, otherwise row
+         *   source[i] - na of b. Plain containers take two gathers running
+         *   in the memory space of out.
+         */
+        template<class Src, typename T, typename Alloc, class Rows>
+        void merge_column(const Src& a, const Src& b, thrust::host_vector<T, Alloc>& dst, const Rows& source, std::size_t na)
+        {
+            merge_gather(a, b, dst, source, na);
+        }
+
+        template<class Src, typename T, typename Alloc, class Rows>
+        void merge_column(const Src& a, const Src& b, thrust::device_vector<T, Alloc>& dst, const Rows& source, std::size_t na)
+        {
+            merge_gather(a, b, dst, source, na);
+        }
+
+        // Packed containers share words between rows, so they are written serially
+        template<class Src, class Dst, class Rows>
+        void merge_column(const Src& a, const Src& b, Dst& dst, const Rows& source, std::size_t na)
+        {
+            for (std::size_t i = 0; i < source.size(); ++i)
+            {
+                const std::size_t s = source[i];
+                dst[i] = s < na ? a[s] : b[s - na];
+            }
+        }
+
+
+        template<int N, int Size>
+        struct merge_rows_loop
+        {
+            template<class Array, class OutArray, class Rows>
+            static void apply(const Array& a, const Array& b, OutArray& out, const Rows& source)
+            {
+                merge_column(a.template get<N>(), b.template get<N>(), out.template get<N>(), source, a.size());
+                record_bytes_moved(rows_footprint(out.template get<N>(), source.size()));
+
+                merge_rows_loop<N+1, Size>::apply(a, b, out, source);
+            }
+        };
+
+        template<int Size>
+        struct merge_rows_loop<Size, Size>
+        {
+            template<class Array, class OutArray, class Rows>
+            static void apply(const Array&, const Array&, OutArray&, const Rows&) {}
+        };
+
+    } // end namespace detail
+
+
+
+    template<class InputIterator, class OutArray>
+    void concatenate(InputIterator first, InputIterator last, OutArray& out)
+    {
+        MUSE_SCOPED_TIMER("concatenate");
+
+        std::size_t n = 0;
+        for (InputIterator i = first; i != last; ++i)
+        {
+            n += (*i)->size();
+        }
+
+        out.resize(n);
+
+#ifdef _OPENMP
+        if (n >= muse::detail::parallel_copy_rows)
+        {
+#pragma omp parallel
+#pragma omp single
+            muse::detail::concatenate_loop<0, multiarray_size<OutArray>::value>::apply(first, last, &out);
+            return;
+        }
+#endif
+        muse::detail::concatenate_loop<0, multiarray_size<OutArray>::value>::apply_serial(first, last, &out);
+    }
+
+
+
+    template<int K, class Array, class OutArray>
+    void merge_by_column(const Array& a, const Array& b, OutArray& out)
+    {
+        MUSE_SCOPED_TIMER("merge_by_column");
+
+        const std::size_t na = a.size();
+        const std::size_t nb = b.size();
+
+        out.resize(na + nb);
+
+        // Single stable merge of keys, rows of a go first among equal keys.
+        // Source rows are kept in the memory space of out.
+        typename muse::detail::row_vector<typename multiarray_element<K, OutArray>::type>::type source(na + nb);
+        thrust::merge_by_key(a.template get<K>().begin(), a.template get<K>().end(),
+                             b.template get<K>().begin(), b.template get<K>().end(),
+                             thrust::make_counting_iterator<std::size_t>(0),
+                             thrust::make_counting_iterator<std::size_t>(na),
+                             out.template get<K>().begin(),
+                             source.begin());
+
+        // Key container is already written by the merge
+        muse::detail::merge_rows_loop<0, K>::apply(a, b, out, source);
+        muse::detail::merge_rows_loop<K + 1, multiarray_size<Array>::value>::apply(a, b, out, source);
+    }
+
+
+
+    template<class OutArray>
+    void concatenate(std::initializer_list<typename muse::detail::concatenate_part<OutArray>::type> parts, OutArray& out)
+    {
+        std::vector<const OutArray*> arrays;
+        for (typename std::initializer_list<typename muse::detail::concatenate_part<OutArray>::type>::const_iterator
+                 i = parts.begin(); i != parts.end(); ++i)
+        {
+            arrays.push_back(&i->get());
+        }
+        muse::concatenate(arrays.begin(), arrays.end(), out);
+    }
+
+
+} // end namespace muse
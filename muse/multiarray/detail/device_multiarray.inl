@@ -4,6 +4,7 @@
 #pragma once
 
 #include <thrust/device_vector.h>
+#include <muse/multiarray/detail/instrumentation.inl>
 
 namespace muse
 {
@@ -114,7 +115,7 @@ namespace muse
                 : head(0), tail(0) {};
 
             explicit cons_device(size_type n)
-                : head(n), tail(n) {};
+                : head(n), tail(n) { muse::detail::record_allocation(muse::detail::container_footprint(head).capacity_bytes); }
 
             // Accessors
             inline
@@ -143,7 +144,7 @@ namespace muse
                     get() const { return muse::get<N>(*this); }
 
             // Methods
-            void resize(size_type n) { head.resize(n); tail.resize(n); }
+            void resize(size_type n) { muse::detail::resize_container(head, n); tail.resize(n); }
 
             size_type size(void) const {return head.size(); }
 
@@ -170,7 +171,7 @@ namespace muse
                 : head(0) {};
 
             explicit cons_device(size_type n)
-                : head(n) {}
+                : head(n) { muse::detail::record_allocation(muse::detail::container_footprint(head).capacity_bytes); }
 
             // Accessors
             inline
@@ -196,7 +197,7 @@ namespace muse
                 get() const { return muse::get<N>(*this); }
 
             // Methods
-            void resize(size_type n) { head.resize(n); }
+            void resize(size_type n) { muse::detail::resize_container(head, n); }
 
             size_type size(void) const {return head.size(); }
         };
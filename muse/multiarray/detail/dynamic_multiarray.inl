@@ -0,0 +1,387 @@
+/*! \file dynamic_multiarray.inl
+ *  \brief Inline file for dynamic_multiarray.h.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/host_multiarray.inl>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <muse/multiarray/column_view.h>
+#include <thrust/host_vector.h>
+#include <thrust/gather.h>
+#include <thrust/copy.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/functional.h>
+#include <thrust/memory.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace muse
+{
+
+
+    /*!
+     *   Element type of a \p dynamic_multiarray column
+     */
+    enum dynamic_type
+    {
+        dynamic_int8,
+        dynamic_uint8,
+        dynamic_int16,
+        dynamic_uint16,
+        dynamic_int32,
+        dynamic_uint32,
+        dynamic_int64,
+        dynamic_uint64,
+        dynamic_float32,
+        dynamic_float64,
+        dynamic_bool
+    };
+
+
+    namespace detail
+    {
+
+        inline dynamic_type dynamic_integer_type(std::size_t size, bool is_signed)
+        {
+            switch (size)
+            {
+                case 1: return is_signed ? dynamic_int8 : dynamic_uint8;
+                case 2: return is_signed ? dynamic_int16 : dynamic_uint16;
+                case 4: return is_signed ? dynamic_int32 : dynamic_uint32;
+                default: return is_signed ? dynamic_int64 : dynamic_uint64;
+            }
+        }
+
+
+        // dynamic_type of element type T
+        template<typename T, bool Integral = std::is_integral<T>::value>
+        struct dynamic_type_of;
+
+        template<typename T>
+        struct dynamic_type_of<T, true>
+        {
+            static dynamic_type value(void) { return dynamic_integer_type(sizeof(T), std::is_signed<T>::value); }
+        };
+
+        template<>
+        struct dynamic_type_of<bool, true>
+        {
+            static dynamic_type value(void) { return dynamic_bool; }
+        };
+
+        template<>
+        struct dynamic_type_of<float, false>
+        {
+            static dynamic_type value(void) { return dynamic_float32; }
+        };
+
+        template<>
+        struct dynamic_type_of<double, false>
+        {
+            static dynamic_type value(void) { return dynamic_float64; }
+        };
+
+
+        // Fixed-width integer of given size and signedness
+        template<std::size_t Size, bool Signed> struct fixed_width_integer;
+        template<> struct fixed_width_integer<1, true>  { typedef int8_t type; };
+        template<> struct fixed_width_integer<1, false> { typedef uint8_t type; };
+        template<> struct fixed_width_integer<2, true>  { typedef int16_t type; };
+        template<> struct fixed_width_integer<2, false> { typedef uint16_t type; };
+        template<> struct fixed_width_integer<4, true>  { typedef int32_t type; };
+        template<> struct fixed_width_integer<4, false> { typedef uint32_t type; };
+        template<> struct fixed_width_integer<8, true>  { typedef int64_t type; };
+        template<> struct fixed_width_integer<8, false> { typedef uint64_t type; };
+
+
+        /*
+         *   Element type columns of element type T are stored as. Integers of the
+         *   same size and signedness (long and long long, char and int8_t) map to
+         *   one fixed-width type, so they map to one column type as well.
+         */
+        template<typename T, bool Integral = std::is_integral<T>::value && !std::is_same<T, bool>::value>
+        struct dynamic_storage
+        {
+            typedef T type;
+        };
+
+        template<typename T>
+        struct dynamic_storage<T, true>
+        {
+            typedef typename fixed_width_integer<sizeof(T), std::is_signed<T>::value>::type type;
+        };
+
+
+
+        /*
+         *   Type-erased column. Every bulk operation is a virtual call per
+         *   column, the loop over rows runs in the typed implementation.
+         */
+        class dynamic_column
+        {
+        public:
+            virtual ~dynamic_column(void) {}
+
+            virtual dynamic_type type(void) const = 0;
+
+            virtual std::size_t size(void) const = 0;
+
+            virtual void resize(std::size_t n) = 0;
+
+            // Replaces rows with rows[map[i]]
+            virtual void gather(const thrust::host_vector<std::size_t>& map) = 0;
+
+            // Keeps rows with keep[i] set, count of them is known
+            virtual void compact(const thrust::host_vector<bool>& keep, std::size_t count) = 0;
+
+            // Row ids in stable ascending order of elements
+            virtual void sort_permutation(thrust::host_vector<std::size_t>& rows) const = 0;
+
+            virtual footprint memory_footprint(void) const = 0;
+        };
+
+
+        // Typed column, values are shared with host_multiarray containers until written
+        template<typename T>
+        class dynamic_column_impl : public dynamic_column
+        {
+        public:
+            typedef thrust::host_vector<T> container_type;
+
+            explicit dynamic_column_impl(std::size_t n)
+                : values(allocate_container<container_type>(n)) {}
+
+            explicit dynamic_column_impl(const std::shared_ptr<container_type>& shared)
+                : values(shared) {}
+
+            dynamic_type type(void) const { return dynamic_type_of<T>::value(); }
+
+            std::size_t size(void) const { return values->size(); }
+
+            void resize(std::size_t n) { resize_detached(values, n); }
+
+            void gather(const thrust::host_vector<std::size_t>& map)
+            {
+                // New storage, so a shared container is left untouched
+                std::shared_ptr<container_type> result = allocate_container<container_type>(map.size());
+                thrust::gather(map.begin(), map.end(), values->begin(), result->begin());
+                values = result;
+                record_bytes_moved(map.size() * sizeof(T));
+            }
+
+            void compact(const thrust::host_vector<bool>& keep, std::size_t count)
+            {
+                std::shared_ptr<container_type> result = allocate_container<container_type>(count);
+                thrust::copy_if(values->begin(), values->end(), keep.begin(), result->begin(), thrust::identity<bool>());
+                values = result;
+                record_bytes_moved(count * sizeof(T));
+            }
+
+            void sort_permutation(thrust::host_vector<std::size_t>& rows) const
+            {
+                container_type keys(*values);
+                rows.resize(keys.size());
+                thrust::sequence(rows.begin(), rows.end());
+                thrust::stable_sort_by_key(keys.begin(), keys.end(), rows.begin());
+            }
+
+            footprint memory_footprint(void) const { return container_footprint(*values); }
+
+            std::shared_ptr<container_type> values;
+        };
+
+
+        // Creates column of runtime type t
+        inline std::shared_ptr<dynamic_column> make_dynamic_column(dynamic_type t, std::size_t n)
+        {
+            switch (t)
+            {
+                case dynamic_int8:    return std::make_shared<dynamic_column_impl<int8_t> >(n);
+                case dynamic_uint8:   return std::make_shared<dynamic_column_impl<uint8_t> >(n);
+                case dynamic_int16:   return std::make_shared<dynamic_column_impl<int16_t> >(n);
+                case dynamic_uint16:  return std::make_shared<dynamic_column_impl<uint16_t> >(n);
+                case dynamic_int32:   return std::make_shared<dynamic_column_impl<int32_t> >(n);
+                case dynamic_uint32:  return std::make_shared<dynamic_column_impl<uint32_t> >(n);
+                case dynamic_int64:   return std::make_shared<dynamic_column_impl<int64_t> >(n);
+                case dynamic_uint64:  return std::make_shared<dynamic_column_impl<uint64_t> >(n);
+                case dynamic_float32: return std::make_shared<dynamic_column_impl<float> >(n);
+                case dynamic_float64: return std::make_shared<dynamic_column_impl<double> >(n);
+                default:              return std::make_shared<dynamic_column_impl<bool> >(n);
+            }
+        }
+
+
+
+        /*
+         *   Sharing containers of host_multiarray. Plain containers of the
+         *   storage type are shared, packed ones and other integer types of
+         *   the same size are copied into a new column.
+         */
+        template<class Container>
+        inline std::shared_ptr<dynamic_column> dynamic_column_copy(const Container& c)
+        {
+            typedef typename dynamic_storage<typename Container::value_type>::type value_type;
+
+            std::shared_ptr<dynamic_column_impl<value_type> > column =
+                std::make_shared<dynamic_column_impl<value_type> >(c.size());
+            thrust::copy(c.begin(), c.end(), column->values->begin());
+            record_bytes_moved(c.size() * sizeof(value_type));
+            return column;
+        }
+
+        template<typename T>
+        inline std::shared_ptr<dynamic_column> dynamic_column_from(const std::shared_ptr<thrust::host_vector<T> >& c,
+                                                                   std::true_type)
+        {
+            return std::make_shared<dynamic_column_impl<T> >(c);
+        }
+
+        template<class Container>
+        inline std::shared_ptr<dynamic_column> dynamic_column_from(const std::shared_ptr<Container>& c, std::false_type)
+        {
+            return dynamic_column_copy(*c);
+        }
+
+        template<class Container>
+        inline std::shared_ptr<dynamic_column> dynamic_column_from(const std::shared_ptr<Container>& c)
+        {
+            typedef typename Container::value_type value_type;
+            typedef typename dynamic_storage<value_type>::type storage_type;
+
+            return dynamic_column_from(c, std::integral_constant<bool,
+                std::is_same<Container, thrust::host_vector<storage_type> >::value>());
+        }
+
+        template<class HT>
+        inline void dynamic_share_from(const cons_host<HT, null_type>& c, std::vector<std::shared_ptr<dynamic_column> >& out)
+        {
+            c.materialize_head();
+            c.head_shared = true;
+            out.push_back(dynamic_column_from(c.head));
+        }
+
+        template<class HT, class TT>
+        inline void dynamic_share_from(const cons_host<HT, TT>& c, std::vector<std::shared_ptr<dynamic_column> >& out)
+        {
+            c.materialize_head();
+            c.head_shared = true;
+            out.push_back(dynamic_column_from(c.head));
+            dynamic_share_from(c.tail, out);
+        }
+
+
+        // Shares column with a container of the same element type, packed containers never match
+        template<typename T>
+        inline void dynamic_assign_head(std::shared_ptr<thrust::host_vector<T> >& head,
+                                        const std::shared_ptr<thrust::host_vector<T> >& values)
+        {
+            head = values;
+        }
+
+        // Integer of another type with the same size and signedness, copied
+        template<typename T, typename S>
+        inline void dynamic_assign_head(std::shared_ptr<thrust::host_vector<T> >& head,
+                                        const std::shared_ptr<thrust::host_vector<S> >& values)
+        {
+            head = allocate_container<thrust::host_vector<T> >(values->size());
+            thrust::copy(values->begin(), values->end(), head->begin());
+            record_bytes_moved(values->size() * sizeof(T));
+        }
+
+        template<typename T>
+        inline bool dynamic_share_head(std::shared_ptr<thrust::host_vector<T> >& head, const dynamic_column& column, bool assign)
+        {
+            typedef typename dynamic_storage<T>::type storage_type;
+
+            const dynamic_column_impl<storage_type>* c = dynamic_cast<const dynamic_column_impl<storage_type>*>(&column);
+            if (0 != c && assign)
+            {
+                dynamic_assign_head(head, c->values);
+            }
+            return 0 != c;
+        }
+
+        template<class Container>
+        inline bool dynamic_share_head(std::shared_ptr<Container>&, const dynamic_column&, bool)
+        {
+            return false;
+        }
+
+        template<class HT>
+        inline bool dynamic_share_to(cons_host<HT, null_type>& c, const std::vector<std::shared_ptr<dynamic_column> >& columns,
+                                     std::size_t i, std::size_t rows, bool assign)
+        {
+            if (!dynamic_share_head(c.head, *columns[i], assign))
+            {
+                return false;
+            }
+            if (assign)
+            {
+                c.rows = rows;
+                ++c.head_version;
+                c.materialized.set(true);
+                c.head_shared = true;
+            }
+            return true;
+        }
+
+        template<class HT, class TT>
+        inline bool dynamic_share_to(cons_host<HT, TT>& c, const std::vector<std::shared_ptr<dynamic_column> >& columns,
+                                     std::size_t i, std::size_t rows, bool assign)
+        {
+            if (!dynamic_share_head(c.head, *columns[i], assign))
+            {
+                return false;
+            }
+            if (assign)
+            {
+                c.rows = rows;
+                ++c.head_version;
+                c.materialized.set(true);
+                c.head_shared = true;
+            }
+            return dynamic_share_to(c.tail, columns, i + 1, rows, assign);
+        }
+
+
+        // Points every view of a multiarray_view at the matching column
+        struct dynamic_view_columns
+        {
+            const std::vector<std::shared_ptr<dynamic_column> >* columns;
+            bool matches;
+
+            // Read-only views share the column as is
+            template<typename T>
+            void operator()(muse::column_view<const T>& v, int i)
+            {
+                const dynamic_column_impl<T>* c = dynamic_cast<const dynamic_column_impl<T>*>((*columns)[i].get());
+                matches = matches && 0 != c;
+                if (matches)
+                {
+                    v = muse::column_view<const T>(thrust::raw_pointer_cast(c->values->data()), c->values->size());
+                }
+            }
+
+            // Writable views get a container of their own first
+            template<typename T>
+            void operator()(muse::column_view<T>& v, int i)
+            {
+                dynamic_column_impl<T>* c = dynamic_cast<dynamic_column_impl<T>*>((*columns)[i].get());
+                matches = matches && 0 != c;
+                if (matches)
+                {
+                    thrust::host_vector<T>& values = detach_container(c->values);
+                    v = muse::column_view<T>(thrust::raw_pointer_cast(values.data()), values.size());
+                }
+            }
+        };
+
+    } // end namespace detail
+
+
+} // end namespace muse
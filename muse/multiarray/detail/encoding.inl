@@ -0,0 +1,452 @@
+/*! \file encoding.inl
+ *  \brief Inline file for encoding.h.
+ */
+#pragma once
+
+#include <thrust/host_vector.h>
+#include <thrust/copy.h>
+#include <thrust/gather.h>
+#include <thrust/execution_policy.h>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace muse
+{
+
+    // Storage unit of packed containers
+    typedef unsigned long long packed_word;
+
+
+    // forward declarations of packed containers
+    template<typename T, int Bits> class bit_packed_vector;
+    template<typename T> class for_vector;
+
+
+    namespace detail
+    {
+
+        /*
+         *   Container used by host_multiarray for element type T.
+         *   Specialized for encoding tags in encoding.h.
+         */
+        template<typename T>
+        struct host_container
+        {
+            typedef thrust::host_vector<T> type;
+        };
+
+
+        inline int popcount(packed_word w)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_popcountll(w);
+#else
+            int c = 0;
+            for (; w; w &= w - 1) ++c;
+            return c;
+#endif
+        }
+
+
+        // Mask of the lowest bits bits
+        inline packed_word low_mask(int bits)
+        {
+            return bits >= 64 ? ~packed_word(0) : ((packed_word(1) << bits) - 1);
+        }
+
+
+        // Number of bits needed to represent v
+        inline int bit_width(packed_word v)
+        {
+            int w = 0;
+            for (; v; v >>= 1) ++w;
+            return w;
+        }
+
+
+        // Reads bits wide field starting at bit position pos
+        inline packed_word read_field(const packed_word* words, std::size_t pos, int bits)
+        {
+            const std::size_t w = pos >> 6;
+            const int s = static_cast<int>(pos & 63);
+            packed_word v = words[w] >> s;
+            if (s + bits > 64)
+            {
+                v |= words[w + 1] << (64 - s);
+            }
+            return v & low_mask(bits);
+        }
+
+
+        // Writes bits wide field starting at bit position pos
+        inline void write_field(packed_word* words, std::size_t pos, int bits, packed_word v)
+        {
+            const std::size_t w = pos >> 6;
+            const int s = static_cast<int>(pos & 63);
+            const packed_word m = low_mask(bits);
+            v &= m;
+            words[w] = (words[w] & ~(m << s)) | (v << s);
+            if (s + bits > 64)
+            {
+                words[w + 1] = (words[w + 1] & ~(m >> (64 - s))) | (v >> (64 - s));
+            }
+        }
+
+
+        // Converts stored field back to T, sign extending signed types
+        template<typename T, int Bits>
+        struct field_codec
+        {
+            static packed_word encode(T v)
+            {
+                return static_cast<packed_word>(v) & low_mask(Bits);
+            }
+
+            static T decode(packed_word v)
+            {
+                if (std::numeric_limits<T>::is_signed && Bits < 64)
+                {
+                    const int shift = 64 - Bits;
+                    return static_cast<T>(static_cast<long long>(v << shift) >> shift);
+                }
+                return static_cast<T>(v);
+            }
+        };
+
+        template<int Bits>
+        struct field_codec<bool, Bits>
+        {
+            static packed_word encode(bool v) { return v ? 1 : 0; }
+            static bool decode(packed_word v) { return 0 != v; }
+        };
+
+
+        /*
+         *   Kernels over a chunk of 64 fields of a bit-packed container, which
+         *   takes exactly Bits words. The scalar kernels read field by field.
+         */
+        template<typename T, int Bits>
+        struct packed_chunk_scalar
+        {
+            static void decode(const packed_word* cw, T* v)
+            {
+                for (int j = 0; j < 64; ++j)
+                {
+                    v[j] = field_codec<T, Bits>::decode(read_field(cw, j * Bits, Bits));
+                }
+            }
+
+            // Mask of fields in the closed range [lo, hi]
+            static packed_word between(const packed_word* cw, const T& lo, const T& hi)
+            {
+                T v[64];
+                decode(cw, v);
+                packed_word m = 0;
+                for (int j = 0; j < 64; ++j)
+                {
+                    m |= packed_word(!(v[j] < lo) && !(hi < v[j])) << j;
+                }
+                return m;
+            }
+        };
+
+
+#if defined(__AVX2__)
+
+        /*
+         *   AVX2 kernels for fields up to 56 bits wide, 4 fields at a time.
+         *   Every field is read by an unaligned 64-bit gather at its first byte
+         *   and shifted into place, signed fields are sign extended by xor and
+         *   subtract of the sign bit. Fields are then compared as 64-bit signed
+         *   integers. Gathers of the last fields read up to one word past the
+         *   chunk, which is the next chunk or the padding word of the storage.
+         */
+        template<typename T, int Bits>
+        struct packed_chunk_avx2
+        {
+            static __m256i sign_bit(void)
+            {
+                return _mm256_set1_epi64x(std::numeric_limits<T>::is_signed ? (1LL << (Bits - 1)) : 0);
+            }
+
+            // Decodes fields j..j+3, pos holds their bit positions
+            static __m256i load(const packed_word* cw, __m256i pos)
+            {
+                const __m256i bytes = _mm256_srli_epi64(pos, 3);
+                const __m256i shift = _mm256_and_si256(pos, _mm256_set1_epi64x(7));
+                __m256i v = _mm256_i64gather_epi64(reinterpret_cast<const long long*>(reinterpret_cast<const char*>(cw)), bytes, 1);
+                v = _mm256_and_si256(_mm256_srlv_epi64(v, shift), _mm256_set1_epi64x(static_cast<long long>(low_mask(Bits))));
+                return _mm256_sub_epi64(_mm256_xor_si256(v, sign_bit()), sign_bit());
+            }
+
+            // Bound in the 64-bit signed domain, stored fields are below 2^56
+            static long long bound(const T& v)
+            {
+                const packed_word limit = packed_word(1) << 62;
+                if (!std::numeric_limits<T>::is_signed && static_cast<packed_word>(v) > limit)
+                {
+                    return static_cast<long long>(limit);
+                }
+                return static_cast<long long>(v);
+            }
+
+            static void decode(const packed_word* cw, T* v)
+            {
+                long long buffer[64];
+                const __m256i step = _mm256_set1_epi64x(4 * Bits);
+                __m256i pos = _mm256_set_epi64x(3 * Bits, 2 * Bits, Bits, 0);
+                for (int j = 0; j < 64; j += 4)
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + j), load(cw, pos));
+                    pos = _mm256_add_epi64(pos, step);
+                }
+                for (int j = 0; j < 64; ++j)
+                {
+                    v[j] = static_cast<T>(buffer[j]);
+                }
+            }
+
+            static packed_word between(const packed_word* cw, const T& lo, const T& hi)
+            {
+                const __m256i vlo = _mm256_set1_epi64x(bound(lo));
+                const __m256i vhi = _mm256_set1_epi64x(bound(hi));
+                const __m256i step = _mm256_set1_epi64x(4 * Bits);
+                __m256i pos = _mm256_set_epi64x(3 * Bits, 2 * Bits, Bits, 0);
+                packed_word m = 0;
+                for (int j = 0; j < 64; j += 4)
+                {
+                    const __m256i v = load(cw, pos);
+                    const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(vlo, v), _mm256_cmpgt_epi64(v, vhi));
+                    const int in = ~_mm256_movemask_pd(_mm256_castsi256_pd(out)) & 15;
+                    m |= packed_word(in) << j;
+                    pos = _mm256_add_epi64(pos, step);
+                }
+                return m;
+            }
+        };
+
+        /*
+         *   Same for fields up to 25 bits wide with 32-bit lanes, 8 fields at a
+         *   time. Gathers read up to 4 bytes past the chunk.
+         */
+        template<typename T, int Bits>
+        struct packed_chunk_avx2_narrow
+        {
+            static __m256i sign_bit(void)
+            {
+                return _mm256_set1_epi32(std::numeric_limits<T>::is_signed ? (1 << (Bits - 1)) : 0);
+            }
+
+            static __m256i load(const packed_word* cw, __m256i pos)
+            {
+                const __m256i bytes = _mm256_srli_epi32(pos, 3);
+                const __m256i shift = _mm256_and_si256(pos, _mm256_set1_epi32(7));
+                __m256i v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(reinterpret_cast<const char*>(cw)), bytes, 1);
+                v = _mm256_and_si256(_mm256_srlv_epi32(v, shift), _mm256_set1_epi32(static_cast<int>(low_mask(Bits))));
+                return _mm256_sub_epi32(_mm256_xor_si256(v, sign_bit()), sign_bit());
+            }
+
+            // Bound in the 32-bit signed domain, stored fields are within +-2^25
+            static int bound(const T& v)
+            {
+                const long long limit = 1LL << 30;
+                const long long b = packed_chunk_avx2<T, Bits>::bound(v);
+                return static_cast<int>(b < -limit ? -limit : (b > limit ? limit : b));
+            }
+
+            static __m256i first_positions(void)
+            {
+                return _mm256_set_epi32(7 * Bits, 6 * Bits, 5 * Bits, 4 * Bits, 3 * Bits, 2 * Bits, Bits, 0);
+            }
+
+            static void decode(const packed_word* cw, T* v)
+            {
+                int buffer[64];
+                const __m256i step = _mm256_set1_epi32(8 * Bits);
+                __m256i pos = first_positions();
+                for (int j = 0; j < 64; j += 8)
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + j), load(cw, pos));
+                    pos = _mm256_add_epi32(pos, step);
+                }
+                for (int j = 0; j < 64; ++j)
+                {
+                    v[j] = static_cast<T>(buffer[j]);
+                }
+            }
+
+            static packed_word between(const packed_word* cw, const T& lo, const T& hi)
+            {
+                const __m256i vlo = _mm256_set1_epi32(bound(lo));
+                const __m256i vhi = _mm256_set1_epi32(bound(hi));
+                const __m256i step = _mm256_set1_epi32(8 * Bits);
+                __m256i pos = first_positions();
+                packed_word m = 0;
+                for (int j = 0; j < 64; j += 8)
+                {
+                    const __m256i v = load(cw, pos);
+                    const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, v), _mm256_cmpgt_epi32(v, vhi));
+                    const int in = ~_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 255;
+                    m |= packed_word(in) << j;
+                    pos = _mm256_add_epi32(pos, step);
+                }
+                return m;
+            }
+        };
+
+        // Narrowest lanes the field width allows
+        template<typename T, int Bits, int Lanes = (Bits <= 25 ? 8 : (Bits <= 56 ? 4 : 0))>
+        struct packed_chunk : packed_chunk_scalar<T, Bits> {};
+
+        template<typename T, int Bits>
+        struct packed_chunk<T, Bits, 8> : packed_chunk_avx2_narrow<T, Bits> {};
+
+        template<typename T, int Bits>
+        struct packed_chunk<T, Bits, 4> : packed_chunk_avx2<T, Bits> {};
+
+#else
+
+        template<typename T, int Bits>
+        struct packed_chunk : packed_chunk_scalar<T, Bits> {};
+
+#endif // __AVX2__
+
+
+
+        /*
+         *   Proxy returned by non-const operator[] of packed containers
+         */
+        template<class Container>
+        class packed_reference
+        {
+        public:
+            typedef typename Container::value_type value_type;
+            typedef typename Container::size_type size_type;
+
+            packed_reference(Container* c, size_type i)
+                : container(c), index(i) {}
+
+            operator value_type() const { return container->get(index); }
+
+            packed_reference& operator=(const value_type& v)
+            {
+                container->set(index, v);
+                return *this;
+            }
+
+            packed_reference& operator=(const packed_reference& r)
+            {
+                container->set(index, static_cast<value_type>(r));
+                return *this;
+            }
+
+            packed_reference& operator+=(const value_type& v)
+            {
+                container->set(index, static_cast<value_type>(container->get(index) + v));
+                return *this;
+            }
+
+        private:
+            Container* container;
+            size_type index;
+        };
+
+
+        /*
+         *   Random access iterator over packed containers.
+         *   Reference is packed_reference for mutable iterators and
+         *   value_type for const ones. Writes through it touch words shared
+         *   with neighbouring elements, so Thrust algorithms writing through
+         *   it have to run sequentially, e.g. thrust::copy(thrust::seq, ...).
+         */
+        template<class Container, class Pointer, class Reference>
+        class packed_iterator
+        {
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef typename Container::value_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef void pointer;
+            typedef Reference reference;
+
+            packed_iterator(void)
+                : container(0), index(0) {}
+
+            packed_iterator(Pointer c, difference_type i)
+                : container(c), index(i) {}
+
+            reference operator*() const { return make_reference(index, static_cast<Reference*>(0)); }
+            reference operator[](difference_type n) const { return make_reference(index + n, static_cast<Reference*>(0)); }
+
+            packed_iterator& operator++() { ++index; return *this; }
+            packed_iterator& operator--() { --index; return *this; }
+            packed_iterator operator++(int) { packed_iterator t(*this); ++index; return t; }
+            packed_iterator operator--(int) { packed_iterator t(*this); --index; return t; }
+            packed_iterator& operator+=(difference_type n) { index += n; return *this; }
+            packed_iterator& operator-=(difference_type n) { index -= n; return *this; }
+            packed_iterator operator+(difference_type n) const { return packed_iterator(container, index + n); }
+            packed_iterator operator-(difference_type n) const { return packed_iterator(container, index - n); }
+            difference_type operator-(const packed_iterator& o) const { return index - o.index; }
+
+            bool operator==(const packed_iterator& o) const { return index == o.index; }
+            bool operator!=(const packed_iterator& o) const { return index != o.index; }
+            bool operator<(const packed_iterator& o) const { return index < o.index; }
+            bool operator>(const packed_iterator& o) const { return index > o.index; }
+            bool operator<=(const packed_iterator& o) const { return index <= o.index; }
+            bool operator>=(const packed_iterator& o) const { return index >= o.index; }
+
+        private:
+            value_type make_reference(difference_type i, value_type*) const { return container->get(i); }
+            packed_reference<Container> make_reference(difference_type i, packed_reference<Container>*) const
+            {
+                return packed_reference<Container>(container, i);
+            }
+
+            Pointer container;
+            difference_type index;
+        };
+
+
+        /*
+         *   Copy and gather into a container. Plain containers run in the Thrust
+         *   system of the iterators, packed ones sequentially.
+         */
+        template<class InputIterator, class OutputIterator>
+        inline OutputIterator copy_elements(InputIterator first, InputIterator last, OutputIterator result)
+        {
+            return thrust::copy(first, last, result);
+        }
+
+        template<class InputIterator, class Container, class Pointer, class Reference>
+        inline packed_iterator<Container, Pointer, Reference>
+            copy_elements(InputIterator first, InputIterator last, packed_iterator<Container, Pointer, Reference> result)
+        {
+            return thrust::copy(thrust::seq, first, last, result);
+        }
+
+        template<class MapIterator, class InputIterator, class OutputIterator>
+        inline OutputIterator gather_elements(MapIterator first, MapIterator last, InputIterator input, OutputIterator result)
+        {
+            return thrust::gather(first, last, input, result);
+        }
+
+        template<class MapIterator, class InputIterator, class Container, class Pointer, class Reference>
+        inline packed_iterator<Container, Pointer, Reference>
+            gather_elements(MapIterator first, MapIterator last, InputIterator input,
+                            packed_iterator<Container, Pointer, Reference> result)
+        {
+            return thrust::gather(thrust::seq, first, last, input, result);
+        }
+
+    } // end namespace detail
+
+} // end namespace muse
@@ -0,0 +1,230 @@
+/*! \file group_by.inl
+ *  \brief Inline file for group_by.h.
+ */
+#pragma once
+
+#include <muse/multiarray/host_multiarray.h>
+#include <muse/multiarray/detail/hash_table.inl>
+#include <thrust/host_vector.h>
+#include <type_traits>
+
+namespace muse
+{
+
+
+    // forward declaration for aggregates
+    template <typename A0 = null_type, typename A1 = null_type, typename A2 = null_type,
+              typename A3 = null_type, typename A4 = null_type, typename A5 = null_type,
+              typename A6 = null_type, typename A7 = null_type, typename A8 = null_type>
+    struct aggregates;
+
+
+    /*!
+     *   Forward declaration of group_by function
+     */
+    template<int K, class InArray, class OutArray, class Aggregates>
+    void group_by(const InArray& in, OutArray& out, const Aggregates& aggs);
+
+    /*!
+     *   Forward declaration of group_by function without aggregates
+     */
+    template<int K, class InArray, class OutArray>
+    void group_by(const InArray& in, OutArray& out);
+
+
+
+    namespace detail
+    {
+
+        /*
+         *   Output containers are written by several partitions at once, which
+         *   is safe only when every element has its own storage. Bit-packed
+         *   containers share words between neighbouring rows.
+         */
+        template<class Container>
+        struct group_by_output
+        {
+            static const bool value = std::is_same<typename Container::reference,
+                                                   typename Container::value_type&>::value;
+        };
+
+        /*
+         *   Row to group assignment shared by all aggregates.
+         *   Rows are visited in partition order; positions index rows[].
+         */
+        struct group_by_plan
+        {
+            // rows ordered by hash partition
+            thrust::host_vector<std::size_t> rows;
+
+            // hashes of rows[]
+            thrust::host_vector<hash_value_type> hashes;
+
+            // partition p owns positions [offsets[p], offsets[p+1])
+            thrust::host_vector<std::size_t> offsets;
+
+            // group id of position local to its partition
+            thrust::host_vector<std::size_t> groups;
+
+            // 1 when position opens its group
+            thrust::host_vector<unsigned char> first;
+
+            // partition p owns groups [group_offsets[p], group_offsets[p+1])
+            thrust::host_vector<std::size_t> group_offsets;
+
+            long partitions(void) const { return static_cast<long>(offsets.size()) - 1; }
+        };
+
+
+        template<class Container>
+        void group_by_build(const Container& keys, group_by_plan& plan)
+        {
+            typedef typename Container::value_type key_type;
+
+            const int bits = hash_partition_bits(keys.size());
+            hash_partition_rows(keys, bits, muse::key_hash<key_type>(), plan.rows, plan.hashes, plan.offsets);
+
+            const long partitions = plan.partitions();
+            plan.groups.resize(keys.size());
+            plan.first.resize(keys.size());
+            plan.group_offsets.resize(partitions + 1);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for (long p = 0; p < partitions; ++p)
+            {
+                const std::size_t begin = plan.offsets[p];
+                const std::size_t end   = plan.offsets[p + 1];
+
+                open_addressing_table table;
+                table.reset(end - begin);
+
+                std::size_t count = 0;
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    const std::size_t id = table.insert(keys, plan.rows[i], plan.hashes[i], count);
+                    plan.first[i] = (id == count);
+                    plan.groups[i] = id;
+                    if (id == count) ++count;
+                }
+                plan.group_offsets[p] = count;
+            }
+
+            std::size_t sum = 0;
+            for (long p = 0; p < partitions; ++p)
+            {
+                const std::size_t c = plan.group_offsets[p];
+                plan.group_offsets[p] = sum;
+                sum += c;
+            }
+            plan.group_offsets[partitions] = sum;
+        }
+
+
+        /*
+         *   Runs aggregate Agg for every partition and stores results in
+         *   container acc of the output multiarray
+         */
+        template<class Agg, class InArray, class Container>
+        void group_by_aggregate(const InArray& in, const group_by_plan& plan, Container& acc)
+        {
+            static_assert(group_by_output<Container>::value,
+                          "group_by aggregates have to be stored in plain containers, not packed ones");
+
+            const long partitions = plan.partitions();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for (long p = 0; p < partitions; ++p)
+            {
+                const std::size_t base = plan.group_offsets[p];
+                for (std::size_t i = plan.offsets[p]; i < plan.offsets[p + 1]; ++i)
+                {
+                    if (plan.first[i])
+                    {
+                        Agg::first(acc[base + plan.groups[i]], in, plan.rows[i]);
+                    }
+                    else
+                    {
+                        Agg::update(acc[base + plan.groups[i]], in, plan.rows[i]);
+                    }
+                }
+            }
+        }
+
+
+        // Aggregate list loop; I-th aggregate writes (I+1)-th output container
+        template<class Aggregates, int I>
+        struct group_by_aggregate_loop
+        {
+            template<class InArray, class OutArray>
+            static void apply(const InArray& in, const group_by_plan& plan, OutArray& out)
+            {
+                group_by_aggregate<typename Aggregates::head_type>(in, plan, muse::get<I + 1>(out));
+                group_by_aggregate_loop<typename Aggregates::tail_type, I + 1>::apply(in, plan, out);
+            }
+        };
+
+        template<int I>
+        struct group_by_aggregate_loop<aggregates<>, I>
+        {
+            template<class InArray, class OutArray>
+            static void apply(const InArray&, const group_by_plan&, OutArray&) {}
+        };
+
+    } // end namespace detail
+
+
+
+    template<int K, class InArray, class OutArray, class Aggregates>
+    void group_by(const InArray& in, OutArray& out, const Aggregates&)
+    {
+        MUSE_SCOPED_TIMER("group_by");
+
+        typedef typename multiarray_element<K, InArray>::type key_container;
+        typedef typename multiarray_element<0, OutArray>::type out_key_container;
+
+        static_assert(muse::detail::group_by_output<out_key_container>::value,
+                      "group_by keys have to be stored in a plain container, not a packed one");
+
+        const key_container& keys = muse::get<K>(in);
+
+        muse::detail::group_by_plan plan;
+        muse::detail::group_by_build(keys, plan);
+
+        out.resize(plan.group_offsets.back());
+
+        // Group representatives give keys of the output
+        out_key_container& out_keys = muse::get<0>(out);
+        const long partitions = plan.partitions();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (long p = 0; p < partitions; ++p)
+        {
+            const std::size_t base = plan.group_offsets[p];
+            for (std::size_t i = plan.offsets[p]; i < plan.offsets[p + 1]; ++i)
+            {
+                if (plan.first[i])
+                {
+                    out_keys[base + plan.groups[i]] = keys[plan.rows[i]];
+                }
+            }
+        }
+
+        muse::detail::group_by_aggregate_loop<Aggregates, 0>::apply(in, plan, out);
+    }
+
+
+
+    template<int K, class InArray, class OutArray>
+    void group_by(const InArray& in, OutArray& out)
+    {
+        muse::group_by<K>(in, out, muse::aggregates<>());
+    }
+
+
+} // end namespace muse
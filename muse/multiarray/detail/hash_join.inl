@@ -0,0 +1,231 @@
+/*! \file hash_join.inl
+ *  \brief Inline file for hash_join.h.
+ */
+#pragma once
+
+#include <muse/multiarray/host_multiarray.h>
+#include <muse/multiarray/detail/column_loop.inl>
+#include <muse/multiarray/detail/hash_table.inl>
+#include <thrust/host_vector.h>
+#include <thrust/gather.h>
+
+namespace muse
+{
+
+
+    /*!
+     *   Forward declaration of hash_join function producing row index pairs
+     */
+    template<int K1, int K2, class LeftArray, class RightArray>
+    std::size_t hash_join(const LeftArray& left,
+                          const RightArray& right,
+                          thrust::host_vector<std::size_t>& left_rows,
+                          thrust::host_vector<std::size_t>& right_rows);
+
+    /*!
+     *   Forward declaration of hash_join function materializing joined rows
+     */
+    template<int K1, int K2, class LeftArray, class RightArray, class OutArray>
+    std::size_t hash_join(const LeftArray& left,
+                          const RightArray& right,
+                          OutArray& out);
+
+
+
+    namespace detail
+    {
+
+        // Hashes probe side keys as build side key type, so equal keys hash equal
+        template<typename T>
+        struct converting_hash
+        {
+            template<typename U>
+            hash_value_type operator()(const U& key) const
+            {
+                return muse::key_hash<T>()(static_cast<T>(key));
+            }
+        };
+
+
+        /*
+         *   Build side of a partitioned hash join. Every partition has its own
+         *   table mapping a key to the first build position holding it; further
+         *   positions with the same key are chained through next[].
+         */
+        struct hash_join_build
+        {
+            thrust::host_vector<std::size_t> rows;
+            thrust::host_vector<hash_value_type> hashes;
+            thrust::host_vector<std::size_t> offsets;
+            thrust::host_vector<std::size_t> next;
+            thrust::host_vector<open_addressing_table> tables;
+        };
+
+
+        template<class Container>
+        void hash_join_build_tables(const Container& keys, int bits, hash_join_build& build)
+        {
+            typedef typename Container::value_type key_type;
+
+            hash_partition_rows(keys, bits, muse::key_hash<key_type>(), build.rows, build.hashes, build.offsets);
+
+            const long partitions = static_cast<long>(build.offsets.size()) - 1;
+            build.next.resize(keys.size());
+            build.tables.resize(partitions);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for (long p = 0; p < partitions; ++p)
+            {
+                const std::size_t begin = build.offsets[p];
+                const std::size_t end   = build.offsets[p + 1];
+                open_addressing_table& table = build.tables[p];
+                table.reset(end - begin);
+
+                // Order of positions within one chain is unspecified
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    const std::size_t head = table.insert(keys, build.rows[i], build.hashes[i], i);
+                    build.next[i] = (head == i) ? open_addressing_table::empty_slot : build.next[head];
+                    if (head != i)
+                    {
+                        build.next[head] = i;
+                    }
+                }
+            }
+        }
+
+
+        // Copies rows selected by map from src container to dst container
+        struct gather_rows
+        {
+            const thrust::host_vector<std::size_t>& map;
+
+            explicit gather_rows(const thrust::host_vector<std::size_t>& m)
+                : map(m) {}
+
+            template<class Src, class Dst>
+            void operator()(const Src& src, Dst& dst)
+            {
+                gather_elements(map.begin(), map.end(), src.begin(), dst.begin());
+            }
+        };
+
+    } // end namespace detail
+
+
+
+    template<int K1, int K2, class LeftArray, class RightArray>
+    std::size_t hash_join(const LeftArray& left,
+                          const RightArray& right,
+                          thrust::host_vector<std::size_t>& left_rows,
+                          thrust::host_vector<std::size_t>& right_rows)
+    {
+        MUSE_SCOPED_TIMER("hash_join");
+
+        typedef typename multiarray_element<K1, LeftArray>::type left_container;
+        typedef typename multiarray_element<K2, RightArray>::type right_container;
+        typedef typename right_container::value_type build_key_type;
+
+        const left_container&  left_keys  = muse::get<K1>(left);
+        const right_container& right_keys = muse::get<K2>(right);
+
+        const int bits = muse::detail::hash_partition_bits(
+            left_keys.size() > right_keys.size() ? left_keys.size() : right_keys.size());
+
+        // Build phase
+        muse::detail::hash_join_build build;
+        muse::detail::hash_join_build_tables(right_keys, bits, build);
+
+        // Probe side is partitioned the same way
+        thrust::host_vector<std::size_t> probe_rows;
+        thrust::host_vector<hash_value_type> probe_hashes;
+        thrust::host_vector<std::size_t> probe_offsets;
+        muse::detail::hash_partition_rows(left_keys, bits, muse::detail::converting_hash<build_key_type>(),
+                                          probe_rows, probe_hashes, probe_offsets);
+
+        const long partitions = static_cast<long>(probe_offsets.size()) - 1;
+        const std::size_t none = muse::detail::open_addressing_table::empty_slot;
+
+        // Probe phase, first pass counts matches of every partition
+        thrust::host_vector<std::size_t> match_offsets(partitions + 1);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (long p = 0; p < partitions; ++p)
+        {
+            const muse::detail::open_addressing_table& table = build.tables[p];
+            std::size_t matches = 0;
+            for (std::size_t i = probe_offsets[p]; i < probe_offsets[p + 1]; ++i)
+            {
+                for (std::size_t j = table.find(right_keys, left_keys[probe_rows[i]], probe_hashes[i]);
+                     j != none; j = build.next[j])
+                {
+                    ++matches;
+                }
+            }
+            match_offsets[p] = matches;
+        }
+
+        std::size_t total = 0;
+        for (long p = 0; p < partitions; ++p)
+        {
+            const std::size_t c = match_offsets[p];
+            match_offsets[p] = total;
+            total += c;
+        }
+        match_offsets[partitions] = total;
+
+        left_rows.resize(total);
+        right_rows.resize(total);
+
+        // Second pass writes matches to disjoint ranges of the output
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (long p = 0; p < partitions; ++p)
+        {
+            const muse::detail::open_addressing_table& table = build.tables[p];
+            std::size_t out = match_offsets[p];
+            for (std::size_t i = probe_offsets[p]; i < probe_offsets[p + 1]; ++i)
+            {
+                for (std::size_t j = table.find(right_keys, left_keys[probe_rows[i]], probe_hashes[i]);
+                     j != none; j = build.next[j])
+                {
+                    left_rows[out]  = probe_rows[i];
+                    right_rows[out] = build.rows[j];
+                    ++out;
+                }
+            }
+        }
+
+        return total;
+    }
+
+
+
+    template<int K1, int K2, class LeftArray, class RightArray, class OutArray>
+    std::size_t hash_join(const LeftArray& left,
+                          const RightArray& right,
+                          OutArray& out)
+    {
+        thrust::host_vector<std::size_t> left_rows;
+        thrust::host_vector<std::size_t> right_rows;
+
+        const std::size_t n = muse::hash_join<K1, K2>(left, right, left_rows, right_rows);
+
+        out.resize(n);
+
+        muse::detail::gather_rows gather_left(left_rows);
+        muse::detail::for_each_column_pair<0>(gather_left, left, out);
+
+        muse::detail::gather_rows gather_right(right_rows);
+        muse::detail::for_each_column_pair<multiarray_size<LeftArray>::value>(gather_right, right, out);
+
+        return n;
+    }
+
+
+} // end namespace muse
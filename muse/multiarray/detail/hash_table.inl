@@ -0,0 +1,306 @@
+/*! \file hash_table.inl
+ *  \brief Open-addressing hash table and row partitioning shared by group_by and hash_join.
+ */
+#pragma once
+
+#include <thrust/host_vector.h>
+#include <cstddef>
+#include <cstring>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace muse
+{
+
+    typedef unsigned long long hash_value_type;
+
+
+    /*!
+     *   Default hash function object used by \p group_by and \p hash_join.
+     *   Hashes the object representation of the key, so it is suitable for
+     *   arithmetic types and PODs without padding. Specialize it for other key types.
+     */
+    template<typename T>
+    struct key_hash
+    {
+        hash_value_type operator()(const T& key) const
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&key);
+            hash_value_type h = 0xcbf29ce484222325ULL;
+            std::size_t i = 0;
+            for (; i + sizeof(hash_value_type) <= sizeof(T); i += sizeof(hash_value_type))
+            {
+                hash_value_type w;
+                std::memcpy(&w, bytes + i, sizeof(w));
+                h = mix(h ^ w);
+            }
+            if (i < sizeof(T))
+            {
+                hash_value_type w = 0;
+                std::memcpy(&w, bytes + i, sizeof(T) - i);
+                h = mix(h ^ w);
+            }
+            return h;
+        }
+
+        // 64-bit finalizer of MurmurHash3
+        static hash_value_type mix(hash_value_type h)
+        {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+    };
+
+
+    /*! \cond
+     */
+    // +0.0 and -0.0 compare equal, so they have to hash equal too
+    template<>
+    struct key_hash<double>
+    {
+        hash_value_type operator()(double key) const
+        {
+            if (key == 0.0) key = 0.0;
+            hash_value_type w;
+            std::memcpy(&w, &key, sizeof(w));
+            return muse::key_hash<hash_value_type>::mix(w ^ 0xcbf29ce484222325ULL);
+        }
+    };
+
+    template<>
+    struct key_hash<float>
+    {
+        hash_value_type operator()(float key) const
+        {
+            return key_hash<double>()(key);
+        }
+    };
+    /*! \endcond
+     */
+
+
+
+    namespace detail
+    {
+
+        // Number of worker threads available to host side kernels
+        inline int host_thread_count(void)
+        {
+#ifdef _OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+
+        /*
+         *   Chooses number of hash partitions (power of two) so that a single
+         *   partition hash table stays cache resident and there is enough
+         *   partitions to keep all threads busy.
+         */
+        inline int hash_partition_bits(std::size_t n)
+        {
+            const std::size_t max_rows_per_partition = 16384;
+            const std::size_t min_rows_per_partition = 1024;
+            const int max_bits = 12;
+            const int threads = host_thread_count();
+
+            int bits = 0;
+            while (bits < max_bits &&
+                   ((n >> bits) > max_rows_per_partition ||
+                    ((n >> bits) > min_rows_per_partition && (1 << bits) < 4 * threads)))
+            {
+                ++bits;
+            }
+            return bits;
+        }
+
+
+        // Partition id is taken from the top bits, table slot from the bottom bits
+        inline std::size_t hash_partition(hash_value_type h, int bits)
+        {
+            return 0 == bits ? 0 : static_cast<std::size_t>(h >> (64 - bits));
+        }
+
+
+        /*
+         *   Computes hashes of all keys of a container and partitions row ids
+         *   by the top bits of the hash. Uses per-thread histograms followed by
+         *   a prefix sum and a scatter, so every phase runs in parallel.
+         *
+         *   On return rows[offsets[p] .. offsets[p+1]) holds rows of partition p
+         *   in their original relative order and hashes[] is aligned with rows[].
+         */
+        template<class Container, class Hash>
+        void hash_partition_rows(const Container& keys,
+                                 int bits,
+                                 Hash hasher,
+                                 thrust::host_vector<std::size_t>& rows,
+                                 thrust::host_vector<hash_value_type>& hashes,
+                                 thrust::host_vector<std::size_t>& offsets)
+        {
+            const std::size_t n = keys.size();
+            const std::size_t partitions = std::size_t(1) << bits;
+            const int threads = host_thread_count();
+
+            thrust::host_vector<hash_value_type> h(n);
+            thrust::host_vector<std::size_t> histogram(partitions * threads, 0);
+
+            // Each chunk of rows is handled by one thread, so that the scatter
+            // below keeps the original row order inside a partition
+            const long chunks = threads;
+            const std::size_t chunk = (n + threads - 1) / threads;
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long t = 0; t < chunks; ++t)
+            {
+                const std::size_t first = t * chunk < n ? t * chunk : n;
+                const std::size_t last  = first + chunk < n ? first + chunk : n;
+                std::size_t* hist = &histogram[t * partitions];
+
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    h[i] = hasher(keys[i]);
+                    ++hist[hash_partition(h[i], bits)];
+                }
+            }
+
+            // Partition major, chunk minor exclusive scan
+            offsets.resize(partitions + 1);
+            std::size_t sum = 0;
+            for (std::size_t p = 0; p < partitions; ++p)
+            {
+                offsets[p] = sum;
+                for (long t = 0; t < chunks; ++t)
+                {
+                    const std::size_t c = histogram[t * partitions + p];
+                    histogram[t * partitions + p] = sum;
+                    sum += c;
+                }
+            }
+            offsets[partitions] = sum;
+            rows.resize(n);
+            hashes.resize(n);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long t = 0; t < chunks; ++t)
+            {
+                const std::size_t first = t * chunk < n ? t * chunk : n;
+                const std::size_t last  = first + chunk < n ? first + chunk : n;
+                std::size_t* hist = &histogram[t * partitions];
+
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    const std::size_t dst = hist[hash_partition(h[i], bits)]++;
+                    rows[dst] = i;
+                    hashes[dst] = h[i];
+                }
+            }
+        }
+
+
+        /*
+         *   Linear probing hash table mapping keys to dense ids. Every slot keeps
+         *   the full hash next to the row id, so a probe mostly touches a single
+         *   cache line and keys are compared only on hash match.
+         *
+         *   The table only stores row ids; keys are compared through the
+         *   container the rows come from.
+         */
+        class open_addressing_table
+        {
+        public:
+            static const std::size_t empty_slot = ~std::size_t(0);
+
+            struct slot
+            {
+                hash_value_type hash;
+                std::size_t     row;
+                std::size_t     id;
+            };
+
+            open_addressing_table(void)
+                : mask(0) {}
+
+            // Prepares table for n distinct keys with load factor <= 0.5
+            void reset(std::size_t n)
+            {
+                std::size_t capacity = 16;
+                while (capacity < 2 * n) capacity <<= 1;
+                mask = capacity - 1;
+
+                slot e;
+                e.hash = 0;
+                e.row = empty_slot;
+                e.id = empty_slot;
+                slots.assign(capacity, e);
+            }
+
+            /*
+             *   Looks up key of row r. When it is not present it gets inserted
+             *   with new_id. Returns id of the key.
+             */
+            template<class Container>
+            std::size_t insert(const Container& keys, std::size_t r, hash_value_type h, std::size_t new_id)
+            {
+                std::size_t i = static_cast<std::size_t>(h) & mask;
+                for (;;)
+                {
+                    slot& s = slots[i];
+                    if (empty_slot == s.row)
+                    {
+                        s.hash = h;
+                        s.row = r;
+                        s.id = new_id;
+                        return new_id;
+                    }
+                    if (s.hash == h && keys[s.row] == keys[r])
+                    {
+                        return s.id;
+                    }
+                    i = (i + 1) & mask;
+                }
+            }
+
+            /*
+             *   Looks up key, which is compared against keys of the build container.
+             *   Returns id of the key or empty_slot.
+             */
+            template<class Container, class Key>
+            std::size_t find(const Container& keys, const Key& key, hash_value_type h) const
+            {
+                std::size_t i = static_cast<std::size_t>(h) & mask;
+                for (;;)
+                {
+                    const slot& s = slots[i];
+                    if (empty_slot == s.row)
+                    {
+                        return empty_slot;
+                    }
+                    if (s.hash == h && keys[s.row] == key)
+                    {
+                        return s.id;
+                    }
+                    i = (i + 1) & mask;
+                }
+            }
+
+        private:
+            std::size_t mask;
+            thrust::host_vector<slot> slots;
+        };
+
+    } // end namespace detail
+
+} // end namespace muse
@@ -4,6 +4,12 @@
 #pragma once
 
 #include <thrust/host_vector.h>
+#include <thrust/copy.h>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <muse/multiarray/encoding.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace muse
 {
@@ -17,6 +23,23 @@ namespace muse
     class host_multiarray;
 
 
+    // forward declaration for host_multiarray_snapshot
+    template <typename T0 = null_type, typename T1 = null_type, typename T2 = null_type,
+              typename T3 = null_type, typename T4 = null_type, typename T5 = null_type,
+              typename T6 = null_type, typename T7 = null_type, typename T8 = null_type,
+              typename T9 = null_type>
+    class host_multiarray_snapshot;
+
+
+    /*!
+     *   Tag selecting construction of \p host_multiarray with unmaterialized
+     *   containers, see \p host_multiarray::is_materialized
+     */
+    struct lazy_tag {};
+
+    static const lazy_tag lazy = lazy_tag();
+
+
     template<> struct multiarray_size< host_multiarray<> >
     {
         static const int value = 0;
@@ -50,6 +73,13 @@ namespace muse
         typename muse::access_traits<typename multiarray_element<N, muse::detail::cons_host<HT, TT> >::type >::const_reference_type
             get(const muse::detail::cons_host<HT, TT>& c);
 
+    /*!
+     *   Forward declaration of version function that returns modification counter
+     *   of N-th container of multiarray
+     */
+    template<int N, class HT, class TT>
+    inline
+        unsigned long version(const muse::detail::cons_host<HT, TT>& c);
 
 
     namespace detail
@@ -71,6 +101,24 @@ namespace muse
                 return get_class_host<N-1>::template get<RET>(t.tail);
             }
 
+            template<class HT, class TT>
+            inline static unsigned long version(const cons_host<HT, TT>& t)
+            {
+                return get_class_host<N-1>::version(t.tail);
+            }
+
+            template<class HT, class TT>
+            inline static bool is_materialized(const cons_host<HT, TT>& t)
+            {
+                return get_class_host<N-1>::is_materialized(t.tail);
+            }
+
+            template<class HT, class TT>
+            inline static void release(cons_host<HT, TT>& t)
+            {
+                get_class_host<N-1>::release(t.tail);
+            }
+
         };
 
         template<>
@@ -80,13 +128,31 @@ namespace muse
             template<class RET, class HT, class TT>
             inline static RET get(const cons_host<HT, TT>& t)
             {
-                return t.head;
+                return t.get_head();
             }
 
             template<class RET, class HT, class TT>
             inline static RET get(cons_host<HT, TT>& t)
             {
-                return t.head;
+                return t.get_head();
+            }
+
+            template<class HT, class TT>
+            inline static unsigned long version(const cons_host<HT, TT>& t)
+            {
+                return t.head_version;
+            }
+
+            template<class HT, class TT>
+            inline static bool is_materialized(const cons_host<HT, TT>& t)
+            {
+                return t.materialized.test();
+            }
+
+            template<class HT, class TT>
+            inline static void release(cons_host<HT, TT>& t)
+            {
+                t.release_head();
             }
         };
 
@@ -97,6 +163,124 @@ namespace muse
     namespace detail
     {
 
+        /*
+         *   Returns container for writing. A container still shared with a
+         *   snapshot is copied first, so the snapshot keeps the old content.
+         *   Snapshots are taken by the writer, so use count 1 cannot grow
+         *   behind its back, and a snapshot released by another thread only
+         *   makes the copy unnecessary.
+         */
+        template<class Container>
+        inline Container& detach_container(std::shared_ptr<Container>& p)
+        {
+            if (p.use_count() > 1)
+            {
+                p = std::make_shared<Container>(*p);
+                record_allocation(container_footprint(*p).capacity_bytes);
+                record_bytes_moved(container_footprint(*p).size_bytes);
+            }
+            else
+            {
+                // Reads of the last snapshot released elsewhere happen before our writes
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            return *p;
+        }
+
+
+        /*
+         *   New container of n elements holding the first min(n, size) elements
+         *   of c, so a shared container is resized without copying the rest.
+         *   Packed containers copy their words or re-encode the prefix at once.
+         */
+        template<class Container>
+        inline std::shared_ptr<Container> prefix_container(const Container& c, std::size_t n)
+        {
+            const std::size_t keep = n < c.size() ? n : c.size();
+            std::shared_ptr<Container> p = allocate_container<Container>(n);
+            thrust::copy(c.begin(), c.begin() + keep, p->begin());
+            record_bytes_moved(keep * sizeof(typename Container::value_type));
+            return p;
+        }
+
+        template<typename T, int Bits>
+        inline std::shared_ptr<muse::bit_packed_vector<T, Bits> > prefix_container(const muse::bit_packed_vector<T, Bits>& c, std::size_t n)
+        {
+            const std::size_t keep = n < c.size() ? n : c.size();
+            const std::size_t end = keep * Bits;
+            std::shared_ptr<muse::bit_packed_vector<T, Bits> > p = allocate_container<muse::bit_packed_vector<T, Bits> >(n);
+            thrust::copy(c.words().begin(), c.words().begin() + (end + 63) / 64, p->words().begin());
+            if (end & 63)
+            {
+                p->words()[end >> 6] &= low_mask(static_cast<int>(end & 63));
+            }
+            record_bytes_moved((end + 63) / 64 * sizeof(packed_word));
+            return p;
+        }
+
+        template<typename T>
+        inline std::shared_ptr<muse::for_vector<T> > prefix_container(const muse::for_vector<T>& c, std::size_t n)
+        {
+            const std::size_t keep = n < c.size() ? n : c.size();
+            std::shared_ptr<muse::for_vector<T> > p = std::make_shared<muse::for_vector<T> >();
+            p->assign(c.begin(), c.begin() + keep);
+            p->resize(n);
+            record_allocation(container_footprint(*p).capacity_bytes);
+            record_bytes_moved(container_footprint(*p).size_bytes);
+            return p;
+        }
+
+
+        /*
+         *   Resizes container to n elements. A container still shared with a
+         *   snapshot is replaced by a new one holding only the elements that
+         *   stay, a cleared one by an empty container.
+         */
+        template<class Container>
+        inline void resize_detached(std::shared_ptr<Container>& p, std::size_t n)
+        {
+            if (p.use_count() > 1)
+            {
+                p = prefix_container(*p, n);
+            }
+            else
+            {
+                // Reads of the last snapshot released elsewhere happen before our writes
+                std::atomic_thread_fence(std::memory_order_acquire);
+                resize_container(*p, n);
+            }
+        }
+
+
+        /*
+         *   Set once the head of a cons_host is allocated. Const readers test
+         *   it without locking, so concurrent first reads of an unmaterialized
+         *   container allocate it once, under the mutex of that container.
+         *   Containers never wait for each other, a copy gets its own mutex.
+         */
+        struct materialized_flag
+        {
+            std::atomic<bool> value;
+            std::mutex mutex;
+
+            explicit materialized_flag(bool v)
+                : value(v) {}
+
+            materialized_flag(const materialized_flag& f)
+                : value(f.test()) {}
+
+            materialized_flag& operator=(const materialized_flag& f)
+            {
+                set(f.test());
+                return *this;
+            }
+
+            bool test(void) const { return value.load(std::memory_order_acquire); }
+
+            void set(bool v) { value.store(v, std::memory_order_release); }
+        };
+
+
         template<class HT, class TT>
         struct cons_host
         {
@@ -104,26 +288,43 @@ namespace muse
             typedef TT tail_type;
 
 
-            typedef thrust::host_vector<head_type> container_head_type;
-            typedef typename thrust::host_vector<head_type>::size_type size_type;
+            typedef typename host_container<head_type>::type container_head_type;
+            typedef typename container_head_type::size_type size_type;
 
 
-            // Attributes
-            container_head_type head;
+            // Attributes, head is shared with snapshots until the next write
+            // and null until the first access when not materialized
+            mutable std::shared_ptr<container_head_type> head;
             tail_type tail;
 
+            // Logical size, size of head once materialized
+            size_type rows;
+
+            // Incremented on every mutable access to head
+            unsigned long head_version;
+
+            // True while head is allocated
+            mutable materialized_flag materialized;
+
+            // Set when head is shared with a snapshot or a dynamic_multiarray,
+            // cleared by the next write, which copies head only when still shared
+            mutable bool head_shared;
+
 
             // Constructors
             cons_host(void)
-                : head(0), tail(0) {};
+                : head(muse::detail::allocate_container<container_head_type>(0)), tail(0), rows(0), head_version(0), materialized(true), head_shared(false) {};
 
             explicit cons_host(size_type n)
-                : head(n), tail(n) {};
+                : head(muse::detail::allocate_container<container_head_type>(n)), tail(n), rows(n), head_version(0), materialized(true), head_shared(false) {};
+
+            cons_host(size_type n, lazy_tag)
+                : head(), tail(n, lazy_tag()), rows(n), head_version(0), materialized(false), head_shared(false) {};
 
             // Accessors
             inline
                 typename access_traits<container_head_type>::reference_type
-                    get_head() { return head; }
+                    get_head() { if (!head) { materialize_head(); } ++head_version; if (head_shared) { detach_head(); } return *head; }
 
             inline
                 typename access_traits<tail_type>::reference_type
@@ -131,7 +332,7 @@ namespace muse
 
             inline
                 typename access_traits<container_head_type>::const_reference_type
-                    get_head() const { return head; }
+                    get_head() const { if (!materialized.test()) { materialize_head(); } return *head; }
 
             inline
                 typename access_traits<tail_type>::const_reference_type
@@ -147,9 +348,44 @@ namespace muse
                     get() const { return muse::get<N>(*this); }
 
             // Methods
-            void resize(size_type n) { head.resize(n); tail.resize(n); }
+            void resize(size_type n)
+            {
+                ++head_version;
+                if (head) { resize_head(n); }
+                rows = n;
+                tail.resize(n);
+            }
+
+            size_type size(void) const {return materialized.test() ? head->size() : rows; }
+
+            // Allocates zero-filled head of logical size on first access, const readers may race here
+            void materialize_head(void) const
+            {
+                if (materialized.test())
+                {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(materialized.mutex);
+                if (!head)
+                {
+                    head = muse::detail::allocate_container<container_head_type>(rows);
+                }
+                materialized.set(true);
+            }
+
+            void release_head(void) { ++head_version; materialized.set(false); head.reset(); head_shared = false; }
+
+            // Copies head shared with a snapshot before the first write
+            void detach_head(void) { muse::detail::detach_container(head); head_shared = false; }
+
+            // Resizes head, a shared one into new storage holding only the kept rows
+            void resize_head(size_type n)
+            {
+                if (head_shared) { muse::detail::resize_detached(head, n); head_shared = false; }
+                else { muse::detail::resize_container(*head, n); }
+            }
 
-            size_type size(void) const {return head.size(); }
+            void share(void) const { head_shared = true; tail.share(); }
 
         };
 
@@ -161,32 +397,49 @@ namespace muse
             typedef null_type tail_type;
             typedef cons_host<HT, null_type> self_type;
 
-            typedef thrust::host_vector<head_type> container_head_type;
-            typedef typename thrust::host_vector<head_type>::size_type size_type;
+            typedef typename host_container<head_type>::type container_head_type;
+            typedef typename container_head_type::size_type size_type;
+
+
+            // Attributes, head is shared with snapshots until the next write
+            // and null until the first access when not materialized
+            mutable std::shared_ptr<container_head_type> head;
+
+            // Logical size, size of head once materialized
+            size_type rows;
 
+            // Incremented on every mutable access to head
+            unsigned long head_version;
 
-            // Attributes
-            container_head_type head;
+            // True while head is allocated
+            mutable materialized_flag materialized;
+
+            // Set when head is shared with a snapshot or a dynamic_multiarray,
+            // cleared by the next write, which copies head only when still shared
+            mutable bool head_shared;
 
 
             // Constructors
             cons_host(void)
-                : head(0) {};
+                : head(muse::detail::allocate_container<container_head_type>(0)), rows(0), head_version(0), materialized(true), head_shared(false) {};
 
             explicit cons_host(size_type n)
-                : head(n) {};
+                : head(muse::detail::allocate_container<container_head_type>(n)), rows(n), head_version(0), materialized(true), head_shared(false) {};
+
+            cons_host(size_type n, lazy_tag)
+                : head(), rows(n), head_version(0), materialized(false), head_shared(false) {};
 
             // Accessors
             inline
                 typename muse::access_traits<container_head_type>::reference_type
-                    get_head() { return head; }
+                    get_head() { if (!head) { materialize_head(); } ++head_version; if (head_shared) { detach_head(); } return *head; }
 
             inline
                 null_type get_tail() { return null_type(); }
 
             inline
                 typename muse::access_traits<container_head_type>::const_reference_type
-                    get_head() const { return head; }
+                    get_head() const { if (!materialized.test()) { materialize_head(); } return *head; }
 
             inline
                 null_type get_tail() const { return null_type(); }
@@ -200,9 +453,43 @@ namespace muse
                 get() const { return muse::get<N>(*this); }
 
             // Methods
-            void resize(size_type n) { head.resize(n); }
+            void resize(size_type n)
+            {
+                ++head_version;
+                if (head) { resize_head(n); }
+                rows = n;
+            }
+
+            size_type size() const {return materialized.test() ? head->size() : rows; }
+
+            // Allocates zero-filled head of logical size on first access, const readers may race here
+            void materialize_head(void) const
+            {
+                if (materialized.test())
+                {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(materialized.mutex);
+                if (!head)
+                {
+                    head = muse::detail::allocate_container<container_head_type>(rows);
+                }
+                materialized.set(true);
+            }
+
+            void release_head(void) { ++head_version; materialized.set(false); head.reset(); head_shared = false; }
 
-            size_type size() const {return head.size(); }
+            // Copies head shared with a snapshot before the first write
+            void detach_head(void) { muse::detail::detach_container(head); head_shared = false; }
+
+            // Resizes head, a shared one into new storage holding only the kept rows
+            void resize_head(size_type n)
+            {
+                if (head_shared) { muse::detail::resize_detached(head, n); head_shared = false; }
+                else { muse::detail::resize_container(*head, n); }
+            }
+
+            void share(void) const { head_shared = true; }
         };
 
 
@@ -255,4 +542,15 @@ namespace muse
     }
 
 
+
+
+
+    template<int N, class HT, class TT>
+    inline
+        unsigned long version(const muse::detail::cons_host<HT, TT>& c)
+    {
+        return muse::detail::get_class_host<N>::version(c);
+    }
+
+
 } // end namespace muse
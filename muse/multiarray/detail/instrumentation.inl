@@ -0,0 +1,291 @@
+/*! \file instrumentation.inl
+ *  \brief Inline file for instrumentation.h.
+ *
+ *         Hooks called by multiarray operations. They compile to nothing
+ *         unless MUSE_ENABLE_INSTRUMENTATION is defined.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/encoding.inl>
+#include <cstddef>
+#include <memory>
+
+#ifdef MUSE_ENABLE_INSTRUMENTATION
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#endif
+
+namespace muse
+{
+
+
+    template<typename T> class column_view;
+    template<typename T, int Capacity> class small_vector;
+
+
+    /*!
+     *   Memory held by a container or a multiarray
+     */
+    struct footprint
+    {
+        // bytes taken by elements
+        std::size_t size_bytes;
+
+        // bytes allocated
+        std::size_t capacity_bytes;
+
+        footprint(void)
+            : size_bytes(0), capacity_bytes(0) {}
+
+        footprint(std::size_t size, std::size_t capacity)
+            : size_bytes(size), capacity_bytes(capacity) {}
+
+        footprint& operator+=(const footprint& f)
+        {
+            size_bytes += f.size_bytes;
+            capacity_bytes += f.capacity_bytes;
+            return *this;
+        }
+    };
+
+
+
+    namespace detail
+    {
+
+        template<class Container>
+        inline footprint container_footprint(const Container& c)
+        {
+            typedef typename Container::value_type value_type;
+            return footprint(c.size() * sizeof(value_type), c.capacity() * sizeof(value_type));
+        }
+
+        template<typename T, int Bits>
+        inline footprint container_footprint(const muse::bit_packed_vector<T, Bits>& c)
+        {
+            return container_footprint(c.words());
+        }
+
+        template<typename T>
+        inline footprint container_footprint(const muse::for_vector<T>& c)
+        {
+            footprint f = container_footprint(c.words());
+            f += container_footprint(c.block_headers());
+            return f;
+        }
+
+
+        // Views hold no memory of their own
+        template<typename T>
+        inline footprint container_footprint(const muse::column_view<T>& c)
+        {
+            return footprint(c.size() * sizeof(T), 0);
+        }
+
+
+        // Bytes taken by count rows of a container, packed rows take a fraction of their value type
+        template<class Container>
+        inline std::size_t rows_footprint(const Container& c, std::size_t count)
+        {
+            return c.empty() ? 0 : static_cast<std::size_t>(
+                static_cast<double>(container_footprint(c).size_bytes) / c.size() * count);
+        }
+
+
+        // Multiarrays with unmaterialized containers count them without allocating them
+
+        template<int N, class Array>
+        inline auto column_footprint(const Array& a, int)
+            -> decltype(a.template is_materialized<N>(), footprint())
+        {
+            return a.template is_materialized<N>() ? container_footprint(a.template get<N>()) : footprint();
+        }
+
+        template<int N, class Array>
+        inline footprint column_footprint(const Array& a, long)
+        {
+            return container_footprint(a.template get<N>());
+        }
+
+
+        // Accumulates footprint of containers N.. of a multiarray
+        template<int N, int Size>
+        struct footprint_loop
+        {
+            template<class Array>
+            static void apply(const Array& a, footprint& f)
+            {
+                f += column_footprint<N>(a, 0);
+                footprint_loop<N+1, Size>::apply(a, f);
+            }
+        };
+
+        template<int Size>
+        struct footprint_loop<Size, Size>
+        {
+            template<class Array>
+            static void apply(const Array&, footprint&) {}
+        };
+
+        // Memory held by all containers of a multiarray of any memory space
+        template<class Array>
+        inline footprint array_footprint(const Array& a)
+        {
+            footprint f;
+            footprint_loop<0, multiarray_size<Array>::value>::apply(a, f);
+            return f;
+        }
+
+
+#ifdef MUSE_ENABLE_INSTRUMENTATION
+
+        struct instrumentation_timer
+        {
+            unsigned long long calls;
+            double seconds;
+        };
+
+        struct instrumentation_state
+        {
+            std::atomic<unsigned long long> allocations;
+            std::atomic<unsigned long long> bytes_allocated;
+            std::atomic<unsigned long long> bytes_moved;
+            std::atomic<unsigned long long> resize_events;
+
+            std::mutex timers_mutex;
+            std::map<std::string, instrumentation_timer> timers;
+
+            instrumentation_state(void)
+                : allocations(0), bytes_allocated(0), bytes_moved(0), resize_events(0) {}
+        };
+
+        inline instrumentation_state& instrumentation(void)
+        {
+            static instrumentation_state state;
+            return state;
+        }
+
+
+        // Resizes container recording reallocation it causes
+        template<class Container>
+        inline void resize_container(Container& c, std::size_t n)
+        {
+            const footprint before = container_footprint(c);
+            c.resize(n);
+            const footprint after = container_footprint(c);
+
+            if (after.capacity_bytes != before.capacity_bytes)
+            {
+                instrumentation_state& s = instrumentation();
+                s.allocations += 1;
+                s.bytes_allocated += after.capacity_bytes;
+                s.bytes_moved += before.size_bytes < after.size_bytes ? before.size_bytes : after.size_bytes;
+            }
+        }
+
+        // Inline small_vector records moving to heap itself
+        template<typename T, int Capacity>
+        inline void resize_container(muse::small_vector<T, Capacity>& c, std::size_t n)
+        {
+            if (c.is_inline())
+            {
+                c.resize(n);
+                return;
+            }
+            const footprint before = container_footprint(c);
+            c.resize(n);
+            const footprint after = container_footprint(c);
+
+            if (after.capacity_bytes != before.capacity_bytes)
+            {
+                instrumentation_state& s = instrumentation();
+                s.allocations += 1;
+                s.bytes_allocated += after.capacity_bytes;
+                s.bytes_moved += before.size_bytes < after.size_bytes ? before.size_bytes : after.size_bytes;
+            }
+        }
+
+        // Called when a container allocates storage outside of resize
+        inline void record_allocation(std::size_t bytes)
+        {
+            if (bytes)
+            {
+                instrumentation_state& s = instrumentation();
+                s.allocations += 1;
+                s.bytes_allocated += bytes;
+            }
+        }
+
+        // Called when a multiarray is resized
+        inline void record_resize(void)
+        {
+            instrumentation().resize_events += 1;
+        }
+
+        // Called when elements are copied between multiarrays
+        inline void record_bytes_moved(std::size_t bytes)
+        {
+            instrumentation().bytes_moved += bytes;
+        }
+
+
+        class scoped_timer_impl
+        {
+        public:
+            explicit scoped_timer_impl(const char* label)
+                : name(label), start(std::chrono::steady_clock::now()) {}
+
+            ~scoped_timer_impl(void)
+            {
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                instrumentation_state& s = instrumentation();
+                std::lock_guard<std::mutex> lock(s.timers_mutex);
+                instrumentation_timer& t = s.timers[name];
+                t.calls += 1;
+                t.seconds += seconds;
+            }
+
+        private:
+            const char* name;
+            std::chrono::steady_clock::time_point start;
+        };
+
+#define MUSE_DETAIL_CONCAT_IMPL(a, b) a##b
+#define MUSE_DETAIL_CONCAT(a, b) MUSE_DETAIL_CONCAT_IMPL(a, b)
+#define MUSE_SCOPED_TIMER(name) \
+        ::muse::detail::scoped_timer_impl MUSE_DETAIL_CONCAT(muse_scoped_timer_, __LINE__)(name)
+
+#else
+
+        // Compiled out hooks
+
+        template<class Container>
+        inline void resize_container(Container& c, std::size_t n) { c.resize(n); }
+
+        inline void record_allocation(std::size_t) {}
+
+        inline void record_resize(void) {}
+
+        inline void record_bytes_moved(std::size_t) {}
+
+#define MUSE_SCOPED_TIMER(name)
+
+#endif // MUSE_ENABLE_INSTRUMENTATION
+
+
+        // Creates shared container of n elements recording its allocation
+        template<class Container>
+        inline std::shared_ptr<Container> allocate_container(std::size_t n)
+        {
+            std::shared_ptr<Container> c = std::make_shared<Container>(n);
+            record_allocation(container_footprint(*c).capacity_bytes);
+            return c;
+        }
+
+    } // end namespace detail
+
+} // end namespace muse
@@ -0,0 +1,280 @@
+/*! \file partition.inl
+ *  \brief Inline file for partition.h.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/column_loop.inl>
+#include <muse/multiarray/detail/hash_table.inl>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <muse/multiarray/encoding.h>
+#include <thrust/host_vector.h>
+#include <thrust/memory.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace muse
+{
+
+
+    /*!
+     *   Forward declaration of partition_rows function
+     */
+    template<int K, class Array, class KeyFunction>
+    thrust::host_vector<std::size_t> partition_rows(Array& array, KeyFunction key_fn, std::size_t num_buckets);
+
+
+
+    namespace detail
+    {
+
+        /*
+         *   Bucket of every row and scatter positions. Rows are split into
+         *   one chunk per thread, starts[t * buckets + b] is the output row of
+         *   the first row of chunk t falling into bucket b. Chunks are laid out
+         *   in order inside a bucket, so the partition is stable.
+         */
+        struct partition_plan
+        {
+            std::size_t rows;
+            std::size_t buckets;
+            long chunks;
+            std::size_t chunk;
+
+            thrust::host_vector<std::size_t> bucket_of;
+            thrust::host_vector<std::size_t> starts;
+
+            std::size_t first(long t) const { return t * chunk < rows ? t * chunk : rows; }
+            std::size_t last(long t) const { return first(t) + chunk < rows ? first(t) + chunk : rows; }
+        };
+
+
+        // Returns false, when key_fn maps a row past the last bucket
+        template<class Container, class KeyFunction>
+        bool partition_histogram(const Container& keys, KeyFunction key_fn, std::size_t buckets,
+                                 partition_plan& plan, thrust::host_vector<std::size_t>& offsets)
+        {
+            const std::size_t n = keys.size();
+            const int threads = host_thread_count();
+
+            plan.rows = n;
+            plan.buckets = buckets;
+            plan.chunks = threads;
+            plan.chunk = (n + threads - 1) / threads;
+            plan.bucket_of.resize(n);
+            plan.starts.assign(buckets * threads, 0);
+
+            // Chunks stop at the first invalid bucket, nothing is moved then
+            thrust::host_vector<char> invalid(plan.chunks, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long t = 0; t < plan.chunks; ++t)
+            {
+                std::size_t* hist = &plan.starts[t * buckets];
+                for (std::size_t i = plan.first(t); i < plan.last(t); ++i)
+                {
+                    const std::size_t b = key_fn(keys[i]);
+                    if (b >= buckets)
+                    {
+                        invalid[t] = 1;
+                        break;
+                    }
+                    plan.bucket_of[i] = b;
+                    ++hist[b];
+                }
+            }
+
+            for (long t = 0; t < plan.chunks; ++t)
+            {
+                if (invalid[t])
+                {
+                    offsets.clear();
+                    return false;
+                }
+            }
+
+            // Bucket major, chunk minor exclusive scan
+            offsets.resize(buckets + 1);
+            std::size_t sum = 0;
+            for (std::size_t b = 0; b < buckets; ++b)
+            {
+                offsets[b] = sum;
+                for (long t = 0; t < plan.chunks; ++t)
+                {
+                    const std::size_t c = plan.starts[t * buckets + b];
+                    plan.starts[t * buckets + b] = sum;
+                    sum += c;
+                }
+            }
+            offsets[buckets] = sum;
+            return true;
+        }
+
+
+        /*
+         *   Scatters rows of chunk t of src to dst. Every bucket has a
+         *   cache line sized buffer in the thread, values are written to dst
+         *   a full buffer at a time, so the scatter streams whole lines
+         *   instead of touching a line per element.
+         */
+        template<typename T>
+        void partition_scatter_chunk(const T* src, T* dst, const partition_plan& plan, long t)
+        {
+            const std::size_t width = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+            const std::size_t buckets = plan.buckets;
+
+            std::vector<std::size_t> pos(plan.starts.begin() + t * buckets, plan.starts.begin() + (t + 1) * buckets);
+            std::vector<T> buffer(buckets * width);
+            std::vector<std::size_t> fill(buckets, 0);
+
+            for (std::size_t i = plan.first(t); i < plan.last(t); ++i)
+            {
+                const std::size_t b = plan.bucket_of[i];
+                T* line = &buffer[b * width];
+                line[fill[b]++] = src[i];
+                if (fill[b] == width)
+                {
+                    std::copy(line, line + width, dst + pos[b]);
+                    pos[b] += width;
+                    fill[b] = 0;
+                }
+            }
+
+            for (std::size_t b = 0; b < buckets; ++b)
+            {
+                std::copy(&buffer[b * width], &buffer[b * width] + fill[b], dst + pos[b]);
+            }
+        }
+
+        // Plain scatter, used when buffers of all buckets would not stay in cache
+        template<typename T>
+        void partition_scatter_chunk_direct(const T* src, T* dst, const partition_plan& plan, long t)
+        {
+            std::vector<std::size_t> pos(plan.starts.begin() + t * plan.buckets,
+                                         plan.starts.begin() + (t + 1) * plan.buckets);
+
+            for (std::size_t i = plan.first(t); i < plan.last(t); ++i)
+            {
+                dst[pos[plan.bucket_of[i]]++] = src[i];
+            }
+        }
+
+
+        // Serial scatter of any container into plain values
+        template<class Container>
+        thrust::host_vector<typename Container::value_type>
+            partition_values(const Container& src, const partition_plan& plan)
+        {
+            thrust::host_vector<typename Container::value_type> values(plan.rows);
+            thrust::host_vector<std::size_t> pos(plan.starts);
+
+            for (long t = 0; t < plan.chunks; ++t)
+            {
+                std::size_t* p = &pos[t * plan.buckets];
+                for (std::size_t i = plan.first(t); i < plan.last(t); ++i)
+                {
+                    values[p[plan.bucket_of[i]]++] = src[i];
+                }
+            }
+            return values;
+        }
+
+
+        // Reorders one container following the plan
+        struct partition_columns
+        {
+            const partition_plan* plan;
+
+            // Contiguous containers, parallel scatter through write-combining buffers
+            template<typename T, typename Alloc>
+            void operator()(thrust::host_vector<T, Alloc>& c, int)
+            {
+                const std::size_t max_buffered_buckets = 4096;
+
+                thrust::host_vector<T, Alloc> tmp(plan->rows);
+                const T* src = thrust::raw_pointer_cast(c.data());
+                T* dst = thrust::raw_pointer_cast(tmp.data());
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+                for (long t = 0; t < plan->chunks; ++t)
+                {
+                    if (plan->buckets <= max_buffered_buckets)
+                    {
+                        partition_scatter_chunk(src, dst, *plan, t);
+                    }
+                    else
+                    {
+                        partition_scatter_chunk_direct(src, dst, *plan, t);
+                    }
+                }
+
+                c.swap(tmp);
+                record_bytes_moved(plan->rows * sizeof(T));
+            }
+
+            // Frame-of-reference blocks are re-encoded by a single bulk assign
+            template<typename T>
+            void operator()(muse::for_vector<T>& c, int)
+            {
+                const thrust::host_vector<T> values = partition_values(c, *plan);
+                c.assign(values.begin(), values.end());
+                record_bytes_moved(plan->rows * sizeof(T));
+            }
+
+            // Other containers, e.g. bit-packed ones, are written back serially
+            template<class Container>
+            void operator()(Container& c, int)
+            {
+                const thrust::host_vector<typename Container::value_type> values = partition_values(c, *plan);
+                for (std::size_t i = 0; i < plan->rows; ++i)
+                {
+                    c[i] = values[i];
+                }
+                record_bytes_moved(plan->rows * sizeof(typename Container::value_type));
+            }
+        };
+
+    } // end namespace detail
+
+
+
+    template<int K, class Array, class KeyFunction>
+    thrust::host_vector<std::size_t> partition_rows(Array& array, KeyFunction key_fn, std::size_t num_buckets)
+    {
+        MUSE_SCOPED_TIMER("partition_rows");
+
+        thrust::host_vector<std::size_t> offsets;
+        muse::detail::partition_plan plan;
+
+        // No bucket to put a row in
+        if (0 == num_buckets)
+        {
+            assert(0 == array.size());
+            offsets.assign(1, 0);
+            return offsets;
+        }
+
+        const Array& keys = array;
+        if (!muse::detail::partition_histogram(keys.template get<K>(), key_fn, num_buckets, plan, offsets))
+        {
+            return offsets;
+        }
+
+        muse::detail::partition_columns f = { &plan };
+        muse::detail::for_each_column(f, array);
+
+        return offsets;
+    }
+
+
+} // end namespace muse
@@ -0,0 +1,75 @@
+/*! \file ring_multiarray.inl
+ *  \brief Inline file for ring_multiarray.h.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/column_loop.inl>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <thrust/copy.h>
+#include <thrust/memory.h>
+#include <cstddef>
+
+namespace muse
+{
+
+
+    // forward declaration for ring_multiarray
+    template <typename T0 = null_type, typename T1 = null_type, typename T2 = null_type,
+              typename T3 = null_type, typename T4 = null_type, typename T5 = null_type,
+              typename T6 = null_type, typename T7 = null_type, typename T8 = null_type,
+              typename T9 = null_type>
+    class ring_multiarray;
+
+
+
+    namespace detail
+    {
+
+        // Element type of read-only views, null_type stays unchanged
+        template<typename T>
+        struct ring_const_element
+        {
+            typedef const T type;
+        };
+
+        template<>
+        struct ring_const_element<null_type>
+        {
+            typedef null_type type;
+        };
+
+
+        // Copies count rows of a source container starting at first to position of a ring container
+        struct ring_copy_rows
+        {
+            std::size_t first;
+            std::size_t count;
+            std::size_t position;
+
+            template<class Src, class Dst>
+            void operator()(const Src& src, Dst& dst)
+            {
+                thrust::copy(src.begin() + first, src.begin() + first + count, dst.begin() + position);
+                record_bytes_moved(count * sizeof(typename Dst::value_type));
+            }
+        };
+
+
+        // Points every view at rows [position, position + count) of a ring container or view
+        struct ring_view_rows
+        {
+            std::size_t position;
+            std::size_t count;
+
+            template<class Src, class View>
+            void operator()(Src& src, View& view)
+            {
+                view = View(thrust::raw_pointer_cast(src.data()) + position, count);
+            }
+        };
+
+    } // end namespace detail
+
+
+} // end namespace muse
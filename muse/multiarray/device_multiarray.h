@@ -5,6 +5,8 @@
 
 #include <muse/multiarray/detail/common.h>
 #include <muse/multiarray/detail/device_multiarray.inl>
+#include <muse/multiarray/detail/concatenate.inl>
+#include <muse/multiarray/detail/column_loop.inl>
 
 
 namespace muse
@@ -137,7 +139,12 @@ namespace muse
          *  Resizes each of the \p device_multiarray component uniformly to contain n elements
          *  \param n new \p device_multiarray size expressed in elements
          */
-        void resize(size_type n) { inherited::resize(n); }
+        void resize(size_type n)
+        {
+            MUSE_SCOPED_TIMER("device_multiarray::resize");
+            muse::detail::record_resize();
+            inherited::resize(n);
+        }
 
         /*!
          *  Returns the number of elements
@@ -156,6 +163,28 @@ namespace muse
          */
         bool empty(void) const { return 0 == inherited::size(); }
 
+        /*!
+         *  Appends all elements of other at the end of this \p device_multiarray.
+         *  This \p device_multiarray is resized once. Components of a large other
+         *  are copied by their own tasks in parallel, a small one is copied on
+         *  the calling thread.
+         *  \param other \p device_multiarray to append, may be this one
+         */
+        void append(const device_multiarray& other)
+        {
+            MUSE_SCOPED_TIMER("device_multiarray::append");
+            muse::detail::append_rows(*this, other);
+        }
+
+        /*!
+         *  Returns memory held by all components of this \p device_multiarray
+         *  \return sum of element bytes and of allocated bytes
+         */
+        footprint memory_footprint(void) const
+        {
+            return muse::detail::array_footprint(*this);
+        }
+
 
     private:
         device_multiarray(const device_multiarray&);
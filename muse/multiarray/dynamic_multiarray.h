@@ -0,0 +1,359 @@
+/*! \file dynamic_multiarray.h
+ *  \brief A structure of arrays with columns added at run time, in the "host" memory space.
+ */
+#pragma once
+
+#include <muse/multiarray/host_multiarray.h>
+#include <muse/multiarray/multiarray_view.h>
+#include <muse/multiarray/detail/dynamic_multiarray.inl>
+#include <muse/multiarray/detail/column_loop.inl>
+#include <thrust/count.h>
+#include <cassert>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Structure of arrays whose columns are added at run time. Every column
+     *   is a contiguous \p thrust::host_vector of one of the \p dynamic_type
+     *   element types. Bulk operations (\p resize, \p gather, \p sort_by_column,
+     *   \p compact) dispatch once per column to a kernel typed for its element
+     *   type, columns are processed in parallel.
+     *
+     *   When the column types match a statically typed schema, the columns
+     *   can be viewed as a \p multiarray_view or shared with a \p host_multiarray
+     *   without copying. Shared containers are copy-on-write, the first write
+     *   through either side copies the written column.
+     *
+     *   \code
+     *   #include <muse/multiarray/dynamic_multiarray.h>
+     *
+     *   muse::dynamic_multiarray table(1000);
+     *
+     *   // schema discovered from an input file
+     *   std::size_t energy = table.add_column("energy", muse::dynamic_float64);
+     *   std::size_t id     = table.add_column("id", muse::dynamic_int32);
+     *
+     *   table.column<double>(energy)[0] = 1.5;
+     *   table.sort_by_column(energy);
+     *
+     *   // typed fast path
+     *   muse::multiarray_view<const double, const int32_t> v;
+     *   if (table.view(v))
+     *   {
+     *       double e = muse::get<0>(v)[0];
+     *   }
+     *
+     *   \endcode
+     */
+    class dynamic_multiarray
+    {
+
+    public:
+        typedef std::size_t size_type;
+
+        static const size_type npos = ~size_type(0);
+
+        /*!
+         *  This constructor creates an empty \p dynamic_multiarray without columns
+         */
+        dynamic_multiarray(void)
+            : rows(0) {}
+
+        /*!
+         *  This constructor creates a \p dynamic_multiarray of n rows without columns
+         *  \param n number of rows of columns added later
+         */
+        explicit dynamic_multiarray(size_type n)
+            : rows(n) {}
+
+        /*!
+         *  This constructor shares all containers of a \p host_multiarray.
+         *  Columns are named "0", "1", ... Packed containers and integers
+         *  stored as another type of the same size (long long as int64_t) are
+         *  copied into new columns, the others are not copied.
+         *  \param a multiarray to share containers with
+         */
+        template<typename T0, typename T1, typename T2, typename T3, typename T4,
+                 typename T5, typename T6, typename T7, typename T8, typename T9>
+        explicit dynamic_multiarray(const host_multiarray<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>& a)
+            : rows(a.size())
+        {
+            muse::detail::dynamic_share_from(a, columns);
+            for (size_type i = 0; i < columns.size(); ++i)
+            {
+                names.push_back(std::to_string(i));
+            }
+        }
+
+        /*!
+         *  Adds a zero-filled column of run time element type
+         *  \param name column name
+         *  \param type element type
+         *  \return column id
+         */
+        size_type add_column(const std::string& name, dynamic_type type)
+        {
+            columns.push_back(muse::detail::make_dynamic_column(type, rows));
+            names.push_back(name);
+            return columns.size() - 1;
+        }
+
+        /*!
+         *  Adds a zero-filled column of element type T. Integers are stored
+         *  as the fixed-width type of the same size and signedness.
+         *  \param name column name
+         *  \return column id
+         */
+        template<typename T>
+        size_type add_column(const std::string& name)
+        {
+            typedef typename muse::detail::dynamic_storage<T>::type storage_type;
+
+            columns.push_back(std::make_shared<muse::detail::dynamic_column_impl<storage_type> >(rows));
+            names.push_back(name);
+            return columns.size() - 1;
+        }
+
+        /*!
+         *  Returns the number of columns
+         */
+        size_type column_count(void) const { return columns.size(); }
+
+        /*!
+         *  Returns id of the first column named name
+         *  \return column id; npos, when there is no such column
+         */
+        size_type find(const std::string& name) const
+        {
+            for (size_type i = 0; i < names.size(); ++i)
+            {
+                if (names[i] == name)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        const std::string& name(size_type i) const { return names[i]; }
+
+        dynamic_type type(size_type i) const { return columns[i]->type(); }
+
+        /*!
+         *  This method returns true if i-th column holds elements of type T.
+         *  Integers of the same size and signedness are the same type,
+         *  holds<long long>(i) is true for a \p dynamic_int64 column.
+         */
+        template<typename T>
+        bool holds(size_type i) const
+        {
+            typedef typename muse::detail::dynamic_storage<T>::type storage_type;
+
+            return 0 != dynamic_cast<const muse::detail::dynamic_column_impl<storage_type>*>(columns[i].get());
+        }
+
+        /*!
+         *  Returns i-th column for writing, a container shared with a
+         *  \p host_multiarray is copied first
+         *  \tparam T element type, holds<T>(i) has to be true
+         *  \return container of the fixed-width storage type of T
+         */
+        template<typename T>
+        thrust::host_vector<typename muse::detail::dynamic_storage<T>::type>& column(size_type i)
+        {
+            typedef typename muse::detail::dynamic_storage<T>::type storage_type;
+
+            assert(holds<T>(i));
+            return muse::detail::detach_container(
+                static_cast<muse::detail::dynamic_column_impl<storage_type>&>(*columns[i]).values);
+        }
+
+        /*!
+         *  Returns i-th column
+         *  \tparam T element type, holds<T>(i) has to be true
+         *  \return container of the fixed-width storage type of T
+         */
+        template<typename T>
+        const thrust::host_vector<typename muse::detail::dynamic_storage<T>::type>& column(size_type i) const
+        {
+            typedef typename muse::detail::dynamic_storage<T>::type storage_type;
+
+            assert(holds<T>(i));
+            return *static_cast<const muse::detail::dynamic_column_impl<storage_type>&>(*columns[i]).values;
+        }
+
+        /*!
+         *  Returns the number of rows
+         */
+        size_type size(void) const { return rows; }
+
+        bool empty(void) const { return 0 == rows; }
+
+        /*!
+         *  Resizes every column to n rows, new elements are zero
+         */
+        void resize(size_type n)
+        {
+            MUSE_SCOPED_TIMER("dynamic_multiarray::resize");
+            muse::detail::record_resize();
+
+            const long count = static_cast<long>(columns.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long i = 0; i < count; ++i)
+            {
+                columns[i]->resize(n);
+            }
+            rows = n;
+        }
+
+        void clear(void) { resize(0); }
+
+        /*!
+         *  Replaces rows by rows selected by map, i-th row becomes row map[i]
+         *  \param map row ids, each less than size()
+         */
+        void gather(const thrust::host_vector<size_type>& map)
+        {
+            MUSE_SCOPED_TIMER("dynamic_multiarray::gather");
+
+            for (size_type i = 0; i < map.size(); ++i)
+            {
+                assert(map[i] < size());
+            }
+
+            const long count = static_cast<long>(columns.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long i = 0; i < count; ++i)
+            {
+                columns[i]->gather(map);
+            }
+            rows = map.size();
+        }
+
+        /*!
+         *  Sorts rows by k-th column, stable
+         *  \param k key column id
+         *  \return true on success; false, when there is no k-th column
+         */
+        bool sort_by_column(size_type k)
+        {
+            MUSE_SCOPED_TIMER("dynamic_multiarray::sort_by_column");
+
+            if (k >= columns.size())
+            {
+                return false;
+            }
+
+            thrust::host_vector<size_type> map;
+            columns[k]->sort_permutation(map);
+            gather(map);
+            return true;
+        }
+
+        /*!
+         *  Removes rows whose flag is not set, keeping order of the others
+         *  \param keep one flag per row
+         */
+        void compact(const thrust::host_vector<bool>& keep)
+        {
+            MUSE_SCOPED_TIMER("dynamic_multiarray::compact");
+
+            assert(keep.size() == size());
+
+            const size_type kept = thrust::count(keep.begin(), keep.end(), true);
+
+            const long count = static_cast<long>(columns.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long i = 0; i < count; ++i)
+            {
+                columns[i]->compact(keep, kept);
+            }
+            rows = kept;
+        }
+
+        /*!
+         *  Points views of v at the columns without copying. Views of non-const
+         *  elements may write, shared containers are copied before.
+         *  \param v output view, i-th view element type has to be the storage type of
+         *           i-th column (int64_t, not long long)
+         *  \return true on success; false, when column count or a type differs
+         */
+        template<typename T0, typename T1, typename T2, typename T3, typename T4,
+                 typename T5, typename T6, typename T7, typename T8, typename T9>
+        bool view(multiarray_view<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>& v)
+        {
+            typedef multiarray_view<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> view_type;
+
+            if (size_type(multiarray_size<view_type>::value) != columns.size())
+            {
+                return false;
+            }
+
+            muse::detail::dynamic_view_columns f = { &columns, true };
+            muse::detail::for_each_column(f, v);
+            return f.matches;
+        }
+
+        /*!
+         *  Makes containers of a \p host_multiarray share the columns without
+         *  copying. Its previous containers are released.
+         *  \param a output multiarray, i-th element type has to match i-th column
+         *           and must not be an encoding tag. Integers stored as another
+         *           type of the same size (long long as int64_t) are copied.
+         *  \return true on success; false, when column count or a type differs,
+         *          a is then unchanged
+         */
+        template<typename T0, typename T1, typename T2, typename T3, typename T4,
+                 typename T5, typename T6, typename T7, typename T8, typename T9>
+        bool share_to(host_multiarray<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>& a) const
+        {
+            typedef host_multiarray<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> array_type;
+
+            if (size_type(multiarray_size<array_type>::value) != columns.size()
+                || !muse::detail::dynamic_share_to(a, columns, 0, rows, false))
+            {
+                return false;
+            }
+            return muse::detail::dynamic_share_to(a, columns, 0, rows, true);
+        }
+
+        /*!
+         *  Returns memory held by all columns
+         *  \return sum of element bytes and of allocated bytes
+         */
+        footprint memory_footprint(void) const
+        {
+            footprint f;
+            for (size_type i = 0; i < columns.size(); ++i)
+            {
+                f += columns[i]->memory_footprint();
+            }
+            return f;
+        }
+
+    private:
+        dynamic_multiarray(const dynamic_multiarray&);
+        dynamic_multiarray& operator=(const dynamic_multiarray&);
+
+        size_type rows;
+        std::vector<std::string> names;
+        std::vector<std::shared_ptr<muse::detail::dynamic_column> > columns;
+
+    }; // end class dynamic_multiarray
+
+
+} // end namespace muse
@@ -0,0 +1,851 @@
+/*! \file encoding.h
+ *  \brief Bit-packed and frame-of-reference container encodings for host_multiarray.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/encoding.inl>
+#include <algorithm>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Encoding tag selecting bit-packed container of bool.
+     *   Used in place of an element type of \p host_multiarray.
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *
+     *   // second container is muse::bit_vector using 1 bit per element
+     *   muse::host_multiarray<float, muse::packed_bool> x(10000);
+     *
+     *   muse::bit_vector & flags = muse::get<1>(x);
+     *
+     *   \endcode
+     */
+    struct packed_bool {};
+
+
+    /*!
+     *   Encoding tag selecting fixed-width bit-packed container of integers.
+     *   Every element is stored in Bits bits, signed types as two's complement,
+     *   so stored values have to fit in Bits bits.
+     *
+     *   \tparam T    integral element type
+     *   \tparam Bits number of bits per element, 1..64
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *
+     *   // particle type in 0..15 stored in 4 bits
+     *   muse::host_multiarray<float, muse::bit_packed<int, 4> > x(10000);
+     *
+     *   muse::get<1>(x)[0] = 7;
+     *
+     *   \endcode
+     */
+    template<typename T, int Bits>
+    struct bit_packed {};
+
+
+    /*!
+     *   Encoding tag selecting frame-of-reference container of integers.
+     *   Elements are grouped in blocks of 128, every block stores its minimum
+     *   and bit-packed offsets from it, using as few bits as the block needs.
+     *   Sorted or clustered ids compress best.
+     *
+     *   \tparam T integral element type
+     */
+    template<typename T>
+    struct frame_of_reference {};
+
+
+
+    /*!
+     *   Fixed-width bit-packed container. Elements are packed back to back
+     *   into 64-bit words, the least significant bit first. Neighbouring
+     *   elements share words, so Thrust algorithms writing through iterators
+     *   of packed containers have to be called with \p thrust::seq.
+     *
+     *   \tparam T    integral element type or bool
+     *   \tparam Bits number of bits per element, 1..64
+     */
+    template<typename T, int Bits>
+    class bit_packed_vector
+    {
+
+    public:
+        typedef T value_type;
+        typedef std::size_t size_type;
+        typedef muse::detail::packed_reference<bit_packed_vector> reference;
+        typedef T const_reference;
+        typedef muse::detail::packed_iterator<bit_packed_vector, bit_packed_vector*, reference> iterator;
+        typedef muse::detail::packed_iterator<bit_packed_vector, const bit_packed_vector*, T> const_iterator;
+
+        static const int bits = Bits;
+
+        /*!
+         *  This constructor creates an empty \p bit_packed_vector
+         */
+        bit_packed_vector(void)
+            : n(0), data(1, 0) {}
+
+        /*!
+         *  This constructor creates a \p bit_packed_vector with count zero elements
+         *  \param count number of elements to initially create
+         */
+        explicit bit_packed_vector(size_type count)
+            : n(count), data(words_for(count), 0) {}
+
+        /*!
+         *  Resizes container to new_size elements, new elements are zero
+         *  \param new_size new size
+         */
+        void resize(size_type new_size)
+        {
+            if (new_size < n)
+            {
+                // Keep bits past the end cleared, so that growing yields zeros
+                data.resize(words_for(new_size));
+                const std::size_t end = new_size * Bits;
+                if (end & 63)
+                {
+                    data[end >> 6] &= muse::detail::low_mask(static_cast<int>(end & 63));
+                }
+                std::fill(data.begin() + ((end + 63) >> 6), data.end(), packed_word(0));
+            }
+            else
+            {
+                data.resize(words_for(new_size), 0);
+            }
+            n = new_size;
+        }
+
+        size_type size(void) const { return n; }
+
+        bool empty(void) const { return 0 == n; }
+
+        T get(size_type i) const
+        {
+            return muse::detail::field_codec<T, Bits>::decode(
+                muse::detail::read_field(&data[0], i * Bits, Bits));
+        }
+
+        void set(size_type i, const T& v)
+        {
+            muse::detail::write_field(&data[0], i * Bits, Bits, muse::detail::field_codec<T, Bits>::encode(v));
+        }
+
+        T operator[](size_type i) const { return get(i); }
+        reference operator[](size_type i) { return reference(this, i); }
+
+        iterator begin(void) { return iterator(this, 0); }
+        iterator end(void) { return iterator(this, n); }
+        const_iterator begin(void) const { return const_iterator(this, 0); }
+        const_iterator end(void) const { return const_iterator(this, n); }
+
+        /*!
+         *  Returns packed words. Storage has one zero padding word at the end.
+         *  \return const reference to packed words
+         */
+        const thrust::host_vector<packed_word>& words(void) const { return data; }
+
+        /*!
+         *  Returns packed words for bulk modifications.
+         *  Bits past size() have to stay zero.
+         *  \return reference to packed words
+         */
+        thrust::host_vector<packed_word>& words(void) { return data; }
+
+    private:
+        static size_type words_for(size_type n) { return (n * Bits + 63) / 64 + 1; }
+
+        size_type n;
+        thrust::host_vector<packed_word> data;
+
+    }; // end class bit_packed_vector
+
+
+    /*!
+     *   Bit-packed container of bool, 1 bit per element
+     */
+    typedef bit_packed_vector<bool, 1> bit_vector;
+
+
+
+    /*!
+     *   Frame-of-reference container. Elements are grouped in blocks of
+     *   \p block_size, every block stores its minimum, bit width and packed
+     *   offsets, so random access stays O(1). Writes that do not fit current
+     *   block width re-encode the block. A block growing wider moves to the
+     *   end of the storage, words it leaves are reclaimed once they take half
+     *   of the storage, so a write takes amortized constant time. Bulk
+     *   \p assign is still the cheapest way of filling the container.
+     *
+     *   \tparam T integral element type
+     */
+    template<typename T>
+    class for_vector
+    {
+
+    public:
+        typedef T value_type;
+        typedef std::size_t size_type;
+        typedef muse::detail::packed_reference<for_vector> reference;
+        typedef T const_reference;
+        typedef muse::detail::packed_iterator<for_vector, for_vector*, reference> iterator;
+        typedef muse::detail::packed_iterator<for_vector, const for_vector*, T> const_iterator;
+
+        static const int block_size = 128;
+
+        /*!
+         *   Block header. Block values are base + offset, offsets take
+         *   width bits each and start at word offset of the storage.
+         */
+        struct block_type
+        {
+            T base;
+            int width;
+            size_type offset;
+        };
+
+        /*!
+         *  This constructor creates an empty \p for_vector
+         */
+        for_vector(void)
+            : n(0), unused(0) {}
+
+        /*!
+         *  This constructor creates a \p for_vector with count zero elements
+         *  \param count number of elements to initially create
+         */
+        explicit for_vector(size_type count)
+            : n(0), unused(0) { resize(count); }
+
+        /*!
+         *  Replaces content with [first, last) encoding all blocks in parallel
+         *  \param first beginning of input range
+         *  \param last  end of input range
+         */
+        template<class InputIterator>
+        void assign(InputIterator first, InputIterator last)
+        {
+            const thrust::host_vector<T> values(first, last);
+            n = values.size();
+
+            const long count = static_cast<long>(blocks_for(n));
+            blocks.resize(count);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long b = 0; b < count; ++b)
+            {
+                T v[block_size];
+                load_block(values, b, v);
+                measure_block(v, blocks[b]);
+            }
+
+            size_type words = 0;
+            for (long b = 0; b < count; ++b)
+            {
+                blocks[b].offset = words;
+                words += block_words(blocks[b].width);
+            }
+            data.assign(words, 0);
+            unused = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (long b = 0; b < count; ++b)
+            {
+                if (blocks[b].width)
+                {
+                    T v[block_size];
+                    load_block(values, b, v);
+                    pack_block(v, blocks[b], &data[0] + blocks[b].offset);
+                }
+            }
+        }
+
+        /*!
+         *  Resizes container to new_size elements, new elements are zero
+         *  \param new_size new size
+         */
+        void resize(size_type new_size)
+        {
+            const size_type old_size = n;
+            if (new_size < old_size)
+            {
+                for (size_type k = blocks_for(new_size); k < blocks.size(); ++k)
+                {
+                    unused += block_words(blocks[k].width);
+                }
+                blocks.resize(blocks_for(new_size));
+                n = new_size;
+
+                // Removed slots of the last block take its minimum
+                if (n % block_size)
+                {
+                    T v[block_size];
+                    unpack_block(blocks.size() - 1, v);
+                    encode_block(blocks.size() - 1, v);
+                }
+                reclaim_words();
+            }
+            else
+            {
+                block_type zero;
+                zero.base = T();
+                zero.width = 0;
+                zero.offset = data.size();
+                blocks.resize(blocks_for(new_size), zero);
+                n = new_size;
+
+                // New slots of the former last block are zero
+                if (old_size % block_size && new_size > old_size)
+                {
+                    const size_type k = old_size / block_size;
+                    T v[block_size];
+                    unpack_block(k, v);
+                    std::fill(v + old_size % block_size, v + block_size, T());
+                    encode_block(k, v);
+                    reclaim_words();
+                }
+            }
+        }
+
+        size_type size(void) const { return n; }
+
+        bool empty(void) const { return 0 == n; }
+
+        T get(size_type i) const
+        {
+            const block_type& b = blocks[i / block_size];
+            if (0 == b.width)
+            {
+                return b.base;
+            }
+            const packed_word off = muse::detail::read_field(&data[b.offset], (i % block_size) * b.width, b.width);
+            return static_cast<T>(static_cast<packed_word>(b.base) + off);
+        }
+
+        void set(size_type i, const T& v)
+        {
+            const size_type k = i / block_size;
+            block_type& b = blocks[k];
+            if (b.base <= v && muse::detail::bit_width(static_cast<packed_word>(v) - static_cast<packed_word>(b.base)) <= b.width)
+            {
+                if (b.width)
+                {
+                    muse::detail::write_field(&data[b.offset], (i % block_size) * b.width, b.width,
+                                              static_cast<packed_word>(v) - static_cast<packed_word>(b.base));
+                }
+                return;
+            }
+
+            T values[block_size];
+            unpack_block(k, values);
+            values[i % block_size] = v;
+            encode_block(k, values);
+            reclaim_words();
+        }
+
+        T operator[](size_type i) const { return get(i); }
+        reference operator[](size_type i) { return reference(this, i); }
+
+        iterator begin(void) { return iterator(this, 0); }
+        iterator end(void) { return iterator(this, n); }
+        const_iterator begin(void) const { return const_iterator(this, 0); }
+        const_iterator end(void) const { return const_iterator(this, n); }
+
+        /*!
+         *  Decodes all values of block k. Slots past the end of the last
+         *  block hold its minimum.
+         *  \param k      block id
+         *  \param values receives block_size values
+         */
+        void unpack_block(size_type k, T* values) const
+        {
+            const block_type& b = blocks[k];
+            if (0 == b.width)
+            {
+                std::fill(values, values + block_size, b.base);
+                return;
+            }
+            const packed_word* w = &data[b.offset];
+            for (int j = 0; j < block_size; ++j)
+            {
+                values[j] = static_cast<T>(static_cast<packed_word>(b.base) +
+                                           muse::detail::read_field(w, j * b.width, b.width));
+            }
+        }
+
+        const thrust::host_vector<block_type>& block_headers(void) const { return blocks; }
+
+        /*!
+         *  Returns packed offsets, every block starts at the offset of its header.
+         *  Storage may hold words of blocks moved by writes.
+         *  \return const reference to packed words
+         */
+        const thrust::host_vector<packed_word>& words(void) const { return data; }
+
+    private:
+        static size_type blocks_for(size_type n) { return (n + block_size - 1) / block_size; }
+
+        // Number of elements of block k
+        int block_count(size_type k) const
+        {
+            return (k + 1) * block_size <= n ? block_size : static_cast<int>(n - k * block_size);
+        }
+
+        // Slots past count take the minimum of the block, so they do not widen it
+        static void pad_block(T* v, int count)
+        {
+            if (count <= 0 || count >= block_size)
+            {
+                return;
+            }
+            T lo = v[0];
+            for (int j = 1; j < count; ++j)
+            {
+                lo = v[j] < lo ? v[j] : lo;
+            }
+            std::fill(v + count, v + block_size, lo);
+        }
+
+        // block_size values of width bits take exactly 2 * width words
+        static size_type block_words(int width) { return 2 * width; }
+
+        template<class Vector>
+        void load_block(const Vector& values, size_type k, T* v) const
+        {
+            const size_type first = k * block_size;
+            const int count = first + block_size <= values.size() ? block_size : static_cast<int>(values.size() - first);
+            for (int j = 0; j < count; ++j)
+            {
+                v[j] = values[first + j];
+            }
+            pad_block(v, count);
+        }
+
+        static void measure_block(const T* v, block_type& b)
+        {
+            T lo = v[0];
+            T hi = v[0];
+            for (int j = 1; j < block_size; ++j)
+            {
+                lo = v[j] < lo ? v[j] : lo;
+                hi = hi < v[j] ? v[j] : hi;
+            }
+            b.base = lo;
+            b.width = muse::detail::bit_width(static_cast<packed_word>(hi) - static_cast<packed_word>(lo));
+        }
+
+        static void pack_block(const T* v, const block_type& b, packed_word* w)
+        {
+            for (int j = 0; j < block_size && b.width; ++j)
+            {
+                muse::detail::write_field(w, j * b.width, b.width,
+                                          static_cast<packed_word>(v[j]) - static_cast<packed_word>(b.base));
+            }
+        }
+
+        // Re-encodes block k, a wider block moves to the end of the storage
+        void encode_block(size_type k, T* v)
+        {
+            pad_block(v, block_count(k));
+
+            block_type b = blocks[k];
+            const size_type old_words = block_words(b.width);
+            measure_block(v, b);
+            const size_type new_words = block_words(b.width);
+
+            if (new_words > old_words)
+            {
+                b.offset = data.size();
+                data.resize(data.size() + new_words);
+                unused += old_words;
+            }
+            else
+            {
+                unused += old_words - new_words;
+            }
+
+            if (new_words)
+            {
+                std::fill(data.begin() + b.offset, data.begin() + b.offset + new_words, packed_word(0));
+                pack_block(v, b, &data[0] + b.offset);
+            }
+            blocks[k] = b;
+        }
+
+        // Moves blocks next to each other once unused words take half of the storage
+        void reclaim_words(void)
+        {
+            if (2 * unused <= data.size())
+            {
+                return;
+            }
+
+            thrust::host_vector<packed_word> packed(data.size() - unused);
+            size_type words = 0;
+            for (size_type k = 0; k < blocks.size(); ++k)
+            {
+                const size_type w = block_words(blocks[k].width);
+                std::copy(data.begin() + blocks[k].offset, data.begin() + blocks[k].offset + w, packed.begin() + words);
+                blocks[k].offset = words;
+                words += w;
+            }
+            data.swap(packed);
+            unused = 0;
+        }
+
+        size_type n;
+        size_type unused;
+        thrust::host_vector<block_type> blocks;
+        thrust::host_vector<packed_word> data;
+
+    }; // end class for_vector
+
+
+
+    /*! \cond
+     */
+    namespace detail
+    {
+        template<>
+        struct host_container<muse::packed_bool>
+        {
+            typedef muse::bit_vector type;
+        };
+
+        template<typename T, int Bits>
+        struct host_container<muse::bit_packed<T, Bits> >
+        {
+            typedef muse::bit_packed_vector<T, Bits> type;
+        };
+
+        template<typename T>
+        struct host_container<muse::frame_of_reference<T> >
+        {
+            typedef muse::for_vector<T> type;
+        };
+    } // end namespace detail
+    /*! \endcond
+     */
+
+
+
+    /*!
+     *   Number of set bits of a selection
+     *   \param selection selection mask
+     *   \return number of selected elements
+     */
+    inline std::size_t count_selected(const bit_vector& selection)
+    {
+        const thrust::host_vector<packed_word>& w = selection.words();
+        const long count = static_cast<long>(w.size());
+        long result = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:result)
+#endif
+        for (long i = 0; i < count; ++i)
+        {
+            result += muse::detail::popcount(w[i]);
+        }
+        return static_cast<std::size_t>(result);
+    }
+
+
+    /*!
+     *   Converts selection mask to ascending list of selected element ids
+     *   \param selection selection mask
+     *   \param rows      receives selected element ids
+     */
+    template<class Vector>
+    void selected_rows(const bit_vector& selection, Vector& rows)
+    {
+        const thrust::host_vector<packed_word>& w = selection.words();
+        rows.resize(count_selected(selection));
+
+        std::size_t out = 0;
+        for (std::size_t i = 0; i < w.size(); ++i)
+        {
+            for (packed_word m = w[i]; m; m &= m - 1)
+            {
+                rows[out++] = i * 64 + muse::detail::bit_width((m & (~m + 1)) - 1);
+            }
+        }
+    }
+
+
+    /*!
+     *   Decodes all elements of a bit-packed container, 64 elements at a time.
+     *   Fields up to 56 bits wide are decoded with AVX2 when it is enabled.
+     *
+     *   \param in  packed container
+     *   \param out receives decoded elements
+     */
+    template<typename T, int Bits, class Vector>
+    void unpack(const bit_packed_vector<T, Bits>& in, Vector& out)
+    {
+        out.resize(in.size());
+        const packed_word* w = &in.words()[0];
+        const long chunks = static_cast<long>(in.size() / 64);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (long c = 0; c < chunks; ++c)
+        {
+            // 64 elements of Bits bits take exactly Bits words
+            T v[64];
+            muse::detail::packed_chunk<T, Bits>::decode(w + c * Bits, v);
+            for (int j = 0; j < 64; ++j)
+            {
+                out[c * 64 + j] = v[j];
+            }
+        }
+        for (std::size_t i = chunks * 64; i < in.size(); ++i)
+        {
+            out[i] = in.get(i);
+        }
+    }
+
+
+    /*!
+     *   Decodes all elements of a frame-of-reference container
+     *
+     *   \param in  packed container
+     *   \param out receives decoded elements
+     */
+    template<typename T, class Vector>
+    void unpack(const for_vector<T>& in, Vector& out)
+    {
+        out.resize(in.size());
+        const long count = static_cast<long>(in.block_headers().size());
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (long k = 0; k < count; ++k)
+        {
+            T v[for_vector<T>::block_size];
+            in.unpack_block(k, v);
+            const std::size_t first = k * for_vector<T>::block_size;
+            for (int j = 0; j < for_vector<T>::block_size && first + j < in.size(); ++j)
+            {
+                out[first + j] = v[j];
+            }
+        }
+    }
+
+
+    /*!
+     *   Selects elements of a container in the closed range [lo, hi].
+     *   Generic version for plain containers.
+     *
+     *   \param in        input container
+     *   \param lo        lower bound, inclusive
+     *   \param hi        upper bound, inclusive
+     *   \param selection receives selection mask, bit i is set for selected element i
+     */
+    template<class Vector, typename T>
+    void select_between(const Vector& in, const T& lo, const T& hi, bit_vector& selection)
+    {
+        selection.resize(0);
+        selection.resize(in.size());
+        packed_word* s = &selection.words()[0];
+        const std::size_t n = in.size();
+        const long chunks = static_cast<long>((n + 63) / 64);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (long c = 0; c < chunks; ++c)
+        {
+            const std::size_t first = c * 64;
+            const int count = first + 64 <= n ? 64 : static_cast<int>(n - first);
+            packed_word m = 0;
+            for (int j = 0; j < count; ++j)
+            {
+                const T v = in[first + j];
+                m |= packed_word(!(v < lo) && !(hi < v)) << j;
+            }
+            s[c] = m;
+        }
+    }
+
+
+    /*!
+     *   Selects elements of a bit-packed container in the closed range [lo, hi]
+     *   working directly on the packed words, 64 elements at a time. Fields up
+     *   to 56 bits wide are decoded and compared with AVX2 when it is enabled.
+     *
+     *   \param in        packed container
+     *   \param lo        lower bound, inclusive
+     *   \param hi        upper bound, inclusive
+     *   \param selection receives selection mask
+     */
+    template<typename T, int Bits>
+    void select_between(const bit_packed_vector<T, Bits>& in, const T& lo, const T& hi, bit_vector& selection)
+    {
+        selection.resize(0);
+        selection.resize(in.size());
+        packed_word* s = &selection.words()[0];
+        const packed_word* w = &in.words()[0];
+        const std::size_t n = in.size();
+        const long chunks = static_cast<long>(n / 64);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (long c = 0; c < chunks; ++c)
+        {
+            s[c] = muse::detail::packed_chunk<T, Bits>::between(w + c * Bits, lo, hi);
+        }
+
+        // Last partial chunk field by field, storage ends inside it
+        packed_word m = 0;
+        for (std::size_t i = chunks * 64; i < n; ++i)
+        {
+            const T v = in.get(i);
+            m |= packed_word(!(v < lo) && !(hi < v)) << (i & 63);
+        }
+        if (n & 63)
+        {
+            s[chunks] = m;
+        }
+    }
+
+
+    /*!
+     *   Selects elements of a frame-of-reference container in the closed range
+     *   [lo, hi]. Blocks entirely inside or outside the range are decided from
+     *   block headers alone, the others are compared in the offset domain.
+     *
+     *   \param in        packed container
+     *   \param lo        lower bound, inclusive
+     *   \param hi        upper bound, inclusive
+     *   \param selection receives selection mask
+     */
+    template<typename T>
+    void select_between(const for_vector<T>& in, const T& lo, const T& hi, bit_vector& selection)
+    {
+        typedef typename for_vector<T>::block_type block_type;
+
+        selection.resize(0);
+        selection.resize(in.size());
+        packed_word* s = &selection.words()[0];
+        const std::size_t n = in.size();
+        const long count = static_cast<long>(in.block_headers().size());
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (long k = 0; k < count; ++k)
+        {
+            const block_type& b = in.block_headers()[k];
+            packed_word* out = s + 2 * k;
+
+            // Largest value representable by the block
+            const packed_word span = muse::detail::low_mask(b.width);
+            const packed_word base = static_cast<packed_word>(b.base);
+            const bool lo_below_base = !(b.base < lo);
+            const packed_word lo_off = lo_below_base ? 0 : static_cast<packed_word>(lo) - base;
+
+            if (hi < b.base || (!lo_below_base && lo_off > span))
+            {
+                out[0] = 0;
+                out[1] = 0;
+                continue;
+            }
+
+            const packed_word hi_off = static_cast<packed_word>(hi) - base;
+            if (lo_below_base && hi_off >= span)
+            {
+                out[0] = ~packed_word(0);
+                out[1] = ~packed_word(0);
+                continue;
+            }
+
+            const packed_word* w = &in.words()[0] + b.offset;
+            for (int h = 0; h < 2; ++h)
+            {
+                packed_word off[64];
+                for (int j = 0; j < 64; ++j)
+                {
+                    off[j] = muse::detail::read_field(w, (h * 64 + j) * b.width, b.width);
+                }
+                packed_word m = 0;
+                for (int j = 0; j < 64; ++j)
+                {
+                    m |= packed_word(off[j] >= lo_off && off[j] <= hi_off) << j;
+                }
+                out[h] = m;
+            }
+        }
+
+        // Clear bits past the end
+        thrust::host_vector<packed_word>& words = selection.words();
+        const std::size_t used = (n + 63) / 64;
+        std::fill(words.begin() + used, words.end(), packed_word(0));
+        if (n & 63)
+        {
+            words[n >> 6] &= muse::detail::low_mask(static_cast<int>(n & 63));
+        }
+    }
+
+
+    /*!
+     *   Selects elements equal to value
+     *
+     *   \param in        input container
+     *   \param value     searched value
+     *   \param selection receives selection mask
+     */
+    template<class Vector, typename T>
+    void select_equal(const Vector& in, const T& value, bit_vector& selection)
+    {
+        muse::select_between(in, value, value, selection);
+    }
+
+
+    /*!
+     *   Selects elements of a bit-packed bool container equal to value,
+     *   which is a plain copy or negation of the packed words
+     *
+     *   \param in        packed container
+     *   \param value     searched value
+     *   \param selection receives selection mask
+     */
+    inline void select_equal(const bit_vector& in, bool value, bit_vector& selection)
+    {
+        selection.resize(0);
+        selection.resize(in.size());
+        const packed_word* w = &in.words()[0];
+        packed_word* s = &selection.words()[0];
+        const std::size_t n = in.size();
+        const long count = static_cast<long>((n + 63) / 64);
+        const packed_word flip = value ? 0 : ~packed_word(0);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (long i = 0; i < count; ++i)
+        {
+            s[i] = w[i] ^ flip;
+        }
+        if (n & 63)
+        {
+            s[n >> 6] &= muse::detail::low_mask(static_cast<int>(n & 63));
+        }
+    }
+
+
+} // end namespace muse
@@ -0,0 +1,170 @@
+/*! \file group_by.h
+ *  \brief Hash based grouping and aggregation of multiarray rows.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/group_by.inl>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Aggregates of \p group_by. They live in their own namespace, so
+     *   their names do not hide \p count, \p min and \p max of other namespaces.
+     */
+    namespace agg
+    {
+
+
+        /*!
+         *   Aggregate counting rows of a group
+         */
+        struct count
+        {
+            template<class Acc, class Array>
+            static void first(Acc& acc, const Array&, std::size_t) { acc = 1; }
+
+            template<class Acc, class Array>
+            static void update(Acc& acc, const Array&, std::size_t) { acc += 1; }
+        };
+
+
+        /*!
+         *   Aggregate summing N-th container over rows of a group
+         *
+         *   \tparam N container id within input multiarray
+         */
+        template<int N>
+        struct sum
+        {
+            template<class Acc, class Array>
+            static void first(Acc& acc, const Array& a, std::size_t row) { acc = muse::get<N>(a)[row]; }
+
+            template<class Acc, class Array>
+            static void update(Acc& acc, const Array& a, std::size_t row) { acc += muse::get<N>(a)[row]; }
+        };
+
+
+        /*!
+         *   Aggregate taking minimum of N-th container over rows of a group
+         *
+         *   \tparam N container id within input multiarray
+         */
+        template<int N>
+        struct min
+        {
+            template<class Acc, class Array>
+            static void first(Acc& acc, const Array& a, std::size_t row) { acc = muse::get<N>(a)[row]; }
+
+            template<class Acc, class Array>
+            static void update(Acc& acc, const Array& a, std::size_t row)
+            {
+                if (muse::get<N>(a)[row] < acc) acc = muse::get<N>(a)[row];
+            }
+        };
+
+
+        /*!
+         *   Aggregate taking maximum of N-th container over rows of a group
+         *
+         *   \tparam N container id within input multiarray
+         */
+        template<int N>
+        struct max
+        {
+            template<class Acc, class Array>
+            static void first(Acc& acc, const Array& a, std::size_t row) { acc = muse::get<N>(a)[row]; }
+
+            template<class Acc, class Array>
+            static void update(Acc& acc, const Array& a, std::size_t row)
+            {
+                if (acc < muse::get<N>(a)[row]) acc = muse::get<N>(a)[row];
+            }
+        };
+
+
+    } // end namespace agg
+
+
+
+    /*!
+     *   List of aggregates computed by \p group_by.
+     *   I-th aggregate is stored in (I+1)-th container of the output multiarray.
+     *   Max number of aggregates reduced to 9
+     */
+    template<typename A0, typename A1, typename A2, typename A3, typename A4,
+             typename A5, typename A6, typename A7, typename A8>
+    struct aggregates
+    {
+        typedef A0 head_type;
+        typedef aggregates<A1, A2, A3, A4, A5, A6, A7, A8, null_type> tail_type;
+    };
+
+
+    /*! \cond
+     */
+    template<>
+    struct aggregates<null_type, null_type, null_type, null_type, null_type,
+                      null_type, null_type, null_type, null_type>
+    {
+    };
+    /*! \endcond
+     */
+
+
+    /*!
+     *   Groups rows of a multiarray by K-th container and computes aggregates
+     *   of every group. Grouping is done with an open-addressing hash table:
+     *   rows are first partitioned by hash, then every partition is built and
+     *   aggregated independently, in parallel when OpenMP is enabled.
+     *
+     *   Output multiarray is resized to the number of distinct keys. Its first
+     *   container receives keys, the following ones receive aggregates in order.
+     *   Order of output groups is unspecified. Output containers are written
+     *   in parallel, so they cannot be packed ones (\p packed_bool,
+     *   \p bit_packed, \p frame_of_reference).
+     *
+     *   \tparam K key container id within \p in
+     *
+     *   \param  in   input multiarray
+     *   \param  out  output multiarray
+     *   \param  aggs list of aggregates
+     *
+     *   The following code snippet demonstrates how to use \p group_by to compute
+     *   number of events and total energy per cell
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/group_by.h>
+     *
+     *   // cell id, energy
+     *   muse::host_multiarray<int, float> events(10000);
+     *
+     *   // cell id, count, energy sum, energy max
+     *   muse::host_multiarray<int, int, float, float> cells;
+     *
+     *   muse::group_by<0>(events, cells, muse::aggregates<muse::agg::count, muse::agg::sum<1>, muse::agg::max<1> >());
+     *
+     *   \endcode
+     */
+    template<int K, class InArray, class OutArray, class Aggregates>
+    void group_by(const InArray& in, OutArray& out, const Aggregates& aggs);
+
+
+    /*!
+     *   Stores distinct keys of K-th container of a multiarray in the first
+     *   container of output multiarray.
+     *
+     *   \tparam K key container id within \p in
+     *
+     *   \param  in  input multiarray
+     *   \param  out output multiarray
+     */
+    template<int K, class InArray, class OutArray>
+    void group_by(const InArray& in, OutArray& out);
+
+
+} // end namespace muse
@@ -0,0 +1,92 @@
+/*! \file hash_join.h
+ *  \brief Hash based equi-join of two multiarrays.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/hash_join.inl>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Joins rows of two multiarrays having equal keys. The right multiarray
+     *   is the build side: its rows are partitioned by key hash and every
+     *   partition gets its own open-addressing hash table. Rows of the left
+     *   multiarray are partitioned the same way and probe only the matching
+     *   partition, so build and probe phases run in parallel when OpenMP is
+     *   enabled. Prefer the smaller multiarray as the right one.
+     *
+     *   \tparam K1 key container id within \p left
+     *   \tparam K2 key container id within \p right
+     *
+     *   \param  left       probe side multiarray
+     *   \param  right      build side multiarray
+     *   \param  left_rows  receives row ids of \p left of every matching pair
+     *   \param  right_rows receives row ids of \p right of every matching pair
+     *   \return number of matching pairs
+     *
+     *   Order of the pairs is unspecified.
+     *
+     *   The following code snippet demonstrates how to use \p hash_join
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/hash_join.h>
+     *
+     *   // event id, cell id
+     *   muse::host_multiarray<int, int> events(10000);
+     *
+     *   // cell id, cell volume
+     *   muse::host_multiarray<int, float> cells(100);
+     *
+     *   thrust::host_vector<std::size_t> event_rows;
+     *   thrust::host_vector<std::size_t> cell_rows;
+     *
+     *   muse::hash_join<1, 0>(events, cells, event_rows, cell_rows);
+     *
+     *   \endcode
+     */
+    template<int K1, int K2, class LeftArray, class RightArray>
+    std::size_t hash_join(const LeftArray& left,
+                          const RightArray& right,
+                          thrust::host_vector<std::size_t>& left_rows,
+                          thrust::host_vector<std::size_t>& right_rows);
+
+
+    /*!
+     *   Joins rows of two multiarrays having equal keys and materializes joined
+     *   rows. Output multiarray is resized to the number of matching pairs, its
+     *   leading containers receive containers of \p left and the following ones
+     *   receive containers of \p right.
+     *
+     *   \tparam K1 key container id within \p left
+     *   \tparam K2 key container id within \p right
+     *
+     *   \param  left  probe side multiarray
+     *   \param  right build side multiarray
+     *   \param  out   output multiarray
+     *   \return number of matching pairs
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/hash_join.h>
+     *
+     *   muse::host_multiarray<int, int> events(10000);
+     *   muse::host_multiarray<int, float> cells(100);
+     *
+     *   muse::host_multiarray<int, int, int, float> joined;
+     *
+     *   muse::hash_join<1, 0>(events, cells, joined);
+     *
+     *   \endcode
+     */
+    template<int K1, int K2, class LeftArray, class RightArray, class OutArray>
+    std::size_t hash_join(const LeftArray& left,
+                          const RightArray& right,
+                          OutArray& out);
+
+
+} // end namespace muse
@@ -5,6 +5,8 @@
 
 #include <muse/multiarray/detail/common.h>
 #include <muse/multiarray/detail/host_multiarray.inl>
+#include <muse/multiarray/detail/concatenate.inl>
+#include <muse/multiarray/detail/column_loop.inl>
 
 
 namespace muse
@@ -73,10 +75,141 @@ namespace muse
           get(const muse::detail::cons_host<HT, TT>& t);
 
 
+    /*!
+     *   Returns modification counter of N-th container of \p host_multiarray.
+     *   The counter is incremented by every call of non-const \p get<N>,
+     *   by \p resize and by \p release<N>, so a changed value means the container may have
+     *   been modified since the counter was last read.
+     *
+     *   \tparam N container id within \p host_multiarray structure of containers
+     *   \tparam HT head type
+     *   \tparam TT tail type
+     *
+     *   \param  t const reference to \p host_multiarray instance
+     *   \return modification counter of N-th container
+     */
+    template<int N, class HT, class TT>
+      inline
+        unsigned long version(const muse::detail::cons_host<HT, TT>& t);
+
+
+    /*!
+     *   Immutable view of all containers of a \p host_multiarray taken by
+     *   \p host_multiarray::snapshot. Containers are shared with the multiarray
+     *   until it writes them, the first mutable \p get<N> then copies just
+     *   that container, \p resize copies only the rows it keeps and \p clear
+     *   none. Copies of a snapshot share containers too.
+     *
+     *   A snapshot may be read and released by any thread without locking
+     *   while the multiarray keeps being modified by its own thread.
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *
+     *   typedef muse::host_multiarray<float, int> Particles;
+     *
+     *   Particles x(10000);
+     *
+     *   // O(1), no container is copied
+     *   Particles::snapshot_type s = x.snapshot();
+     *
+     *   // copies container 0 only, s still sees old values
+     *   muse::get<0>(x)[0] = 1.0f;
+     *
+     *   const thrust::host_vector<float> & old = muse::get<0>(s);
+     *
+     *   \endcode
+     */
+    template<typename T0, typename T1, typename T2, typename T3, typename T4,
+             typename T5, typename T6, typename T7, typename T8, typename T9>
+    class host_multiarray_snapshot
+    {
+
+    private:
+        typedef typename muse::detail::map_multiarray_to_cons_host<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>::type cons_type;
+
+    public:
+        typedef typename cons_type::head_type head_type;
+        typedef typename cons_type::tail_type tail_type;
+        typedef typename cons_type::container_head_type container_head_type;
+        typedef typename cons_type::size_type size_type;
+
+        /*!
+         *  This constructor creates an empty \p host_multiarray_snapshot
+         */
+        host_multiarray_snapshot(void)
+            : columns() {};
+
+        /*!
+         *  Returns const reference to N-th container
+         *  \tparam N container id
+         */
+        template<int N>
+            const typename multiarray_element<N, cons_type>::type& get(void) const { return muse::get<N>(columns); }
+
+        /*!
+         *  Returns the number of elements
+         *  \return number of elements
+         */
+        size_type size(void) const { return columns.size(); }
+
+        /*!
+         *  This method returns true if size() == 0
+         *  \return true if size() == 0; false, otherwise
+         */
+        bool empty(void) const { return 0 == columns.size(); }
+
+    private:
+        friend class host_multiarray<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>;
+
+        // Unmaterialized containers stay so, the first read allocates them in the snapshot
+        explicit host_multiarray_snapshot(const cons_type& c)
+            : columns(c) {};
+
+        cons_type columns;
+
+    }; // end class host_multiarray_snapshot
+
+
+    /*!
+     *   Getter function that returns const reference to N-th container
+     *   of \p host_multiarray_snapshot
+     *
+     *   \tparam N container id within \p host_multiarray_snapshot
+     *
+     *   \param  s const reference to \p host_multiarray_snapshot instance
+     *   \return const reference to N-th container
+     */
+    template<int N, typename T0, typename T1, typename T2, typename T3, typename T4,
+                    typename T5, typename T6, typename T7, typename T8, typename T9>
+      inline
+        const typename multiarray_element<N, host_multiarray_snapshot<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> >::type&
+          get(const host_multiarray_snapshot<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>& s)
+    {
+        return s.template get<N>();
+    }
+
+
     /*!
      *   Structure of arrays basing on thrust::host_vector.
      *   Max number of arrays reduced to 10
      *
+     *   An element type may be replaced by an encoding tag from encoding.h
+     *   (\p packed_bool, \p bit_packed, \p frame_of_reference), the matching
+     *   container then stores that column in packed form.
+     *
+     *   A \p host_multiarray constructed with \p muse::lazy allocates no
+     *   container until its first \p get<N>, \p release<N> frees a single
+     *   container while the size is kept. Such an unmaterialized container
+     *   only follows \p resize logically and is allocated zero-filled on the
+     *   next \p get<N>, const \p get<N> included. Concurrent const \p get<N>
+     *   of an unmaterialized container are safe, it is allocated once under
+     *   a lock of that container, later reads only test an atomic flag.
+     *
+     *   Containers are copy-on-write with respect to \p snapshot. References
+     *   returned by mutable \p get<N> before a snapshot was taken must not be
+     *   used for writing after it, call \p get<N> again instead.
+     *
      *   The following code snippet demonstrates how to create and use \p host_multiarray
      *
      *   \code
@@ -114,6 +247,7 @@ namespace muse
         typedef typename inherited::size_type size_type;
 
     public:
+        typedef host_multiarray_snapshot<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> snapshot_type;
 
         /*!
          *  This constructor creates an empty \p host_multiarray
@@ -128,6 +262,19 @@ namespace muse
         explicit host_multiarray(size_type n)
             : inherited(n) {};
 
+        /*!
+         *  This constructor creates a \p host_multiarray with n elements
+         *  without allocating any container, every container is allocated
+         *  at its first \p get<N>
+         *  \param n number of elements
+         *
+         *  \code
+         *  muse::host_multiarray<float, float, int> x(1000000, muse::lazy);
+         *  \endcode
+         */
+        host_multiarray(size_type n, lazy_tag)
+            : inherited(n, lazy_tag()) {};
+
         /*!
          *  Default destructor
          */
@@ -137,7 +284,12 @@ namespace muse
          *  Resizes each of the \p host_multiarray component uniformly to contain n elements
          *  \param n new \p host_multiarray size expressed in elements
          */
-        void resize(size_type n) { inherited::resize(n); }
+        void resize(size_type n)
+        {
+            MUSE_SCOPED_TIMER("host_multiarray::resize");
+            muse::detail::record_resize();
+            inherited::resize(n);
+        }
 
         /*!
          *  Returns the number of elements
@@ -156,6 +308,77 @@ namespace muse
          */
         bool empty(void) const { return 0 == inherited::size(); }
 
+        /*!
+         *  Appends all elements of other at the end of this \p host_multiarray.
+         *  This \p host_multiarray is resized once. Components of a large other
+         *  are copied by their own tasks in parallel, a small one is copied on
+         *  the calling thread.
+         *  \param other \p host_multiarray to append, may be this one
+         */
+        void append(const host_multiarray& other)
+        {
+            MUSE_SCOPED_TIMER("host_multiarray::append");
+            muse::detail::append_rows(*this, other);
+        }
+
+        /*!
+         *  Frees N-th container, the size of this \p host_multiarray is kept.
+         *  The container is allocated again, zero-filled, at the next \p get<N>.
+         *  References to the container are invalidated.
+         *  \tparam N container id
+         *
+         *  \code
+         *  muse::host_multiarray<float, float, int> x(1000000);
+         *
+         *  // phase using containers 0 and 2 only
+         *  x.release<1>();
+         *
+         *  \endcode
+         */
+        template<int N>
+        void release(void)
+        {
+            muse::detail::get_class_host<N>::release(*this);
+        }
+
+        /*!
+         *  This method returns true if N-th container is allocated
+         *  \tparam N container id
+         *  \return false if N-th container was released or never accessed
+         *          since lazy construction; true, otherwise
+         */
+        template<int N>
+        bool is_materialized(void) const
+        {
+            return muse::detail::get_class_host<N>::is_materialized(*this);
+        }
+
+        /*!
+         *  Returns an immutable view of current content in O(1). Containers
+         *  are shared until this \p host_multiarray writes them, a container
+         *  is copied at its first mutable \p get<N>, \p resize copies only
+         *  the rows it keeps.
+         *  Unmaterialized containers are not allocated, the first read of
+         *  the snapshot allocates them there.
+         *  Has to be called by the thread modifying this \p host_multiarray.
+         *  \return snapshot sharing all containers
+         */
+        snapshot_type snapshot(void) const
+        {
+            inherited::share();
+            return snapshot_type(*this);
+        }
+
+        /*!
+         *  Returns memory held by all components of this \p host_multiarray,
+         *  unmaterialized components hold none
+         *  \return sum of element bytes and of allocated bytes
+         */
+        footprint memory_footprint(void) const
+        {
+            return muse::detail::array_footprint(*this);
+        }
+
     private:
         host_multiarray(const host_multiarray&);
         host_multiarray& operator=(const host_multiarray&);
@@ -0,0 +1,295 @@
+/*! \file instrumentation.h
+ *  \brief Memory footprint of multiarrays and allocation/timing counters.
+ *
+ *         Counters and timers are collected only when MUSE_ENABLE_INSTRUMENTATION
+ *         is defined before the first MuSE header is included, otherwise all hooks
+ *         compile to nothing and \p instrumentation::snapshot returns zeros.
+ *         Memory footprint queries are always available.
+ *
+ *         The macro changes inline functions and class layouts of every header,
+ *         so it has to be set the same way in all translation units of a program,
+ *         best as a compiler definition (-DMUSE_ENABLE_INSTRUMENTATION) of the
+ *         whole build. Mixing instrumented and plain translation units violates
+ *         the one definition rule, the linker keeps one of the definitions.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <string>
+
+
+namespace muse
+{
+
+
+    namespace detail
+    {
+
+        // Writes s as a JSON string literal
+        inline void write_json_string(std::ostream& os, const std::string& s)
+        {
+            os << '"';
+            for (std::string::size_type i = 0; i < s.size(); ++i)
+            {
+                const unsigned char c = static_cast<unsigned char>(s[i]);
+                switch (c)
+                {
+                    case '"':  os << "\\\""; break;
+                    case '\\': os << "\\\\"; break;
+                    case '\b': os << "\\b"; break;
+                    case '\f': os << "\\f"; break;
+                    case '\n': os << "\\n"; break;
+                    case '\r': os << "\\r"; break;
+                    case '\t': os << "\\t"; break;
+                    default:
+                        if (c < 0x20)
+                        {
+                            char code[8];
+                            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                            os << code;
+                        }
+                        else
+                        {
+                            os << s[i];
+                        }
+                }
+            }
+            os << '"';
+        }
+
+
+        // Multiarrays with columns added at run time count them themselves
+        template<class Array>
+        inline auto multiarray_footprint(const Array& a, int)
+            -> decltype(a.memory_footprint())
+        {
+            return a.memory_footprint();
+        }
+
+        template<class Array>
+        inline footprint multiarray_footprint(const Array& a, long)
+        {
+            return array_footprint(a);
+        }
+
+    } // end namespace detail
+
+
+    /*!
+     *   Returns memory held by N-th container of a multiarray, containers
+     *   released or not yet materialized hold none
+     *
+     *   \tparam N container id within multiarray
+     *
+     *   \param  a multiarray
+     *   \return bytes taken by elements and bytes allocated
+     */
+    template<int N, class Array>
+    footprint memory_footprint(const Array& a)
+    {
+        return muse::detail::column_footprint<N>(a, 0);
+    }
+
+
+    /*!
+     *   Returns memory held by all containers of a multiarray
+     *
+     *   \param  a multiarray
+     *   \return bytes taken by elements and bytes allocated
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/instrumentation.h>
+     *
+     *   muse::host_multiarray<float, int> x(10000);
+     *
+     *   std::size_t column = muse::memory_footprint<0>(x).capacity_bytes;
+     *   std::size_t total  = muse::memory_footprint(x).capacity_bytes;
+     *
+     *   \endcode
+     */
+    template<class Array>
+    footprint memory_footprint(const Array& a)
+    {
+        return muse::detail::multiarray_footprint(a, 0);
+    }
+
+
+
+    /*! \namespace muse::instrumentation
+     *  \brief Global allocation counters and operation timers.
+     */
+    namespace instrumentation
+    {
+
+        /*!
+         *   Accumulated time of one kind of operation
+         */
+        struct timer_statistics
+        {
+            unsigned long long calls;
+            double seconds;
+        };
+
+
+        /*!
+         *   Global counters of all multiarrays
+         */
+        struct statistics
+        {
+            // container allocations: construction, first access of a lazy
+            // container, copy of a container shared with a snapshot,
+            // small_vector moving to heap and reallocation on resize
+            unsigned long long allocations;
+
+            // bytes requested by these allocations
+            unsigned long long bytes_allocated;
+
+            // bytes copied by reallocations, append, concatenate
+            unsigned long long bytes_moved;
+
+            // multiarray resize calls
+            unsigned long long resize_events;
+
+            // timers of multiarray-wide operations by name
+            std::map<std::string, timer_statistics> timers;
+
+            statistics(void)
+                : allocations(0), bytes_allocated(0), bytes_moved(0), resize_events(0) {}
+        };
+
+
+        /*!
+         *   Returns true when MuSE was compiled with instrumentation
+         */
+        inline bool enabled(void)
+        {
+#ifdef MUSE_ENABLE_INSTRUMENTATION
+            return true;
+#else
+            return false;
+#endif
+        }
+
+
+        /*!
+         *   Returns current values of all counters and timers
+         */
+        inline statistics snapshot(void)
+        {
+            statistics s;
+#ifdef MUSE_ENABLE_INSTRUMENTATION
+            muse::detail::instrumentation_state& state = muse::detail::instrumentation();
+            s.allocations = state.allocations;
+            s.bytes_allocated = state.bytes_allocated;
+            s.bytes_moved = state.bytes_moved;
+            s.resize_events = state.resize_events;
+
+            std::lock_guard<std::mutex> lock(state.timers_mutex);
+            for (std::map<std::string, muse::detail::instrumentation_timer>::const_iterator i = state.timers.begin();
+                 i != state.timers.end(); ++i)
+            {
+                timer_statistics& t = s.timers[i->first];
+                t.calls = i->second.calls;
+                t.seconds = i->second.seconds;
+            }
+#endif
+            return s;
+        }
+
+
+        /*!
+         *   Sets all counters and timers to zero
+         */
+        inline void reset(void)
+        {
+#ifdef MUSE_ENABLE_INSTRUMENTATION
+            muse::detail::instrumentation_state& state = muse::detail::instrumentation();
+            state.allocations = 0;
+            state.bytes_allocated = 0;
+            state.bytes_moved = 0;
+            state.resize_events = 0;
+
+            std::lock_guard<std::mutex> lock(state.timers_mutex);
+            state.timers.clear();
+#endif
+        }
+
+
+        /*!
+         *   Writes statistics as a JSON object
+         *
+         *   \param os output stream
+         *   \param s  statistics to write
+         *
+         *   \code
+         *   // built with -DMUSE_ENABLE_INSTRUMENTATION
+         *   #include <muse/multiarray.h>
+         *   #include <iostream>
+         *
+         *   muse::instrumentation::write_json(std::cout, muse::instrumentation::snapshot());
+         *
+         *   \endcode
+         */
+        inline void write_json(std::ostream& os, const statistics& s)
+        {
+            os << "{\"enabled\": " << (enabled() ? "true" : "false")
+               << ", \"allocations\": " << s.allocations
+               << ", \"bytes_allocated\": " << s.bytes_allocated
+               << ", \"bytes_moved\": " << s.bytes_moved
+               << ", \"resize_events\": " << s.resize_events
+               << ", \"timers\": {";
+
+            for (std::map<std::string, timer_statistics>::const_iterator i = s.timers.begin(); i != s.timers.end(); ++i)
+            {
+                // User timers may have any name
+                os << (i == s.timers.begin() ? "" : ", ");
+                muse::detail::write_json_string(os, i->first);
+                os << ": {\"calls\": " << i->second.calls
+                   << ", \"seconds\": " << i->second.seconds << "}";
+            }
+            os << "}}";
+        }
+
+
+        /*!
+         *   Measures lifetime of the object and accumulates it under a name.
+         *   Compiles to nothing without MUSE_ENABLE_INSTRUMENTATION.
+         *
+         *   \code
+         *   {
+         *       muse::instrumentation::scoped_timer t("step::sort");
+         *       // ...
+         *   }
+         *   \endcode
+         */
+        class scoped_timer
+        {
+        public:
+            /*!
+             *  \param name timer name, has to outlive the timer
+             */
+            explicit scoped_timer(const char* name)
+#ifdef MUSE_ENABLE_INSTRUMENTATION
+                : impl(name) {}
+#else
+                { (void)name; }
+#endif
+
+        private:
+            scoped_timer(const scoped_timer&);
+            scoped_timer& operator=(const scoped_timer&);
+
+#ifdef MUSE_ENABLE_INSTRUMENTATION
+            muse::detail::scoped_timer_impl impl;
+#endif
+        };
+
+    } // end namespace instrumentation
+
+
+} // end namespace muse
@@ -0,0 +1,114 @@
+/*! \file multiarray_view.h
+ *  \brief A non-owning structure of arrays viewing elements owned elsewhere.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/multiarray_view.inl>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Getter function that returns reference to N-th view
+     *   of \p multiarray_view
+     *
+     *   \tparam N view id within \p multiarray_view structure of views
+     *   \tparam HT head type
+     *   \tparam TT tail type
+     *
+     *   \param  t reference to \p multiarray_view instance
+     *   \return reference to N-th view, assigning to it re-targets the view
+     */
+    template<int N, class HT, class TT>
+      inline
+        typename muse::access_traits<typename multiarray_element<N, muse::detail::cons_view<HT, TT> >::type >::reference_type
+          get(muse::detail::cons_view<HT, TT>& t);
+
+
+    /*!
+     *   Getter function that returns const reference to N-th view
+     *   of \p multiarray_view
+     *
+     *   \tparam N view id within \p multiarray_view structure of views
+     *   \tparam HT head type
+     *   \tparam TT tail type
+     *
+     *   \param  t const reference to \p multiarray_view instance
+     *   \return const reference to N-th view
+     */
+    template<int N, class HT, class TT>
+      inline
+        typename muse::access_traits<typename multiarray_element<N, muse::detail::cons_view<HT, TT> >::type >::const_reference_type
+          get(const muse::detail::cons_view<HT, TT>& t);
+
+
+    /*!
+     *   Structure of \p column_view over elements owned elsewhere, e.g. by
+     *   foreign buffers. Max number of arrays reduced to 10
+     *
+     *   A \p multiarray_view does not allocate and cannot be resized, its
+     *   size is the size of the first view and all views are expected to
+     *   have the same size. Copies share the viewed elements.
+     *
+     *   \code
+     *   #include <muse/multiarray/multiarray_view.h>
+     *
+     *   float x[100];
+     *   int   id[100];
+     *
+     *   muse::multiarray_view<float, const int> v;
+     *   muse::get<0>(v) = muse::column_view<float>(x, 100);
+     *   muse::get<1>(v) = muse::column_view<const int>(id, 100);
+     *
+     *   \endcode
+     */
+    template<typename T0, typename T1, typename T2, typename T3, typename T4,
+             typename T5, typename T6, typename T7, typename T8, typename T9>
+    class multiarray_view
+        : public muse::detail::map_multiarray_to_cons_view<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>::type
+    {
+
+    private:
+        typedef typename muse::detail::map_multiarray_to_cons_view<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>::type inherited;
+        typedef typename inherited::size_type size_type;
+
+    public:
+
+        /*!
+         *  This constructor creates a \p multiarray_view of empty views
+         */
+        multiarray_view(void)
+            : inherited() {};
+
+        /*!
+         *  Returns the number of elements
+         *  \return number of elements
+         */
+        size_type size(void) const { return inherited::size(); }
+
+        /*!
+         *  This method returns true if size() == 0
+         *  \return true if size() == 0; false, otherwise
+         */
+        bool empty(void) const { return 0 == inherited::size(); }
+
+    }; // end class multiarray_view
+
+
+    /*! \cond
+     */
+    template<>
+    class multiarray_view<null_type, null_type, null_type, null_type, null_type,
+                          null_type, null_type, null_type, null_type, null_type>
+    {
+    public:
+        typedef null_type inherited;
+    };
+    /*! \endcond
+     */
+
+
+} // end namespace muse
@@ -0,0 +1,59 @@
+/*! \file partition.h
+ *  \brief Partitioning of multiarray rows into buckets.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/partition.inl>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Reorders rows of a host side multiarray so that rows of every bucket
+     *   are contiguous. Bucket of a row is key_fn applied to its K-th element.
+     *   Rows keep their relative order inside a bucket.
+     *
+     *   Runs as a parallel histogram of bucket ids, a prefix sum and a
+     *   parallel scatter of every component. Each thread stages the scattered
+     *   elements in a cache line sized buffer per bucket and writes full
+     *   lines, so the scatter stays bandwidth bound with many buckets.
+     *   Packed components are scattered serially.
+     *
+     *   \tparam K key component id
+     *
+     *   \param  array       multiarray to reorder, e.g. \p host_multiarray
+     *   \param  key_fn      function object mapping a key to a bucket in [0, num_buckets)
+     *   \param  num_buckets number of buckets, 0 only for an empty array
+     *   \return num_buckets + 1 offsets, rows of bucket b are [offsets[b], offsets[b+1]);
+     *           no offsets, when key_fn returns a bucket not less than num_buckets,
+     *           \p array is then unchanged
+     *
+     *   The following code snippet demonstrates how to distribute particles
+     *   among ranks by their cell
+     *
+     *   \code
+     *   #include <muse/multiarray/host_multiarray.h>
+     *   #include <muse/multiarray/partition.h>
+     *
+     *   struct rank_of_cell
+     *   {
+     *       std::size_t operator()(int cell) const { return cell % 16; }
+     *   };
+     *
+     *   muse::host_multiarray<int, float, float, float> particles(100000);
+     *
+     *   thrust::host_vector<std::size_t> offsets =
+     *       muse::partition_rows<0>(particles, rank_of_cell(), 16);
+     *
+     *   // rows of rank 3 are [offsets[3], offsets[4])
+     *
+     *   \endcode
+     */
+    template<int K, class Array, class KeyFunction>
+    thrust::host_vector<std::size_t> partition_rows(Array& array, KeyFunction key_fn, std::size_t num_buckets);
+
+
+} // end namespace muse
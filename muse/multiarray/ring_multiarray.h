@@ -0,0 +1,276 @@
+/*! \file ring_multiarray.h
+ *  \brief A fixed-capacity ring buffer of rows with structure of arrays layout, in the "host" memory space.
+ */
+#pragma once
+
+#include <muse/multiarray/host_multiarray.h>
+#include <muse/multiarray/multiarray_view.h>
+#include <muse/multiarray/detail/ring_multiarray.inl>
+#include <atomic>
+#include <utility>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Ring buffer of rows with fixed capacity. Every column is a single
+     *   allocation of capacity elements, rows are appended at the tail and
+     *   removed from the head, both wrapping around, so no element is ever
+     *   shifted.
+     *
+     *   One producer thread may call \p push_rows while one consumer thread
+     *   reads the live rows and calls \p pop_rows, without locks. Live rows
+     *   of a column are at most two contiguous spans, \p spans and \p window
+     *   expose them as views, so Thrust algorithms and vectorized loops run
+     *   over the ring without copying.
+     *
+     *   Element types have to be plain types, encoding tags are not supported.
+     *
+     *   \code
+     *   #include <muse/multiarray/ring_multiarray.h>
+     *   #include <thrust/reduce.h>
+     *
+     *   typedef muse::ring_multiarray<double, float> Telemetry;
+     *
+     *   Telemetry ring(1 << 20);
+     *
+     *   // producer
+     *   muse::host_multiarray<double, float> batch(1000);
+     *   ring.push_rows(batch);
+     *
+     *   // consumer, mean of the live window of column 1
+     *   Telemetry::view_type first, second;
+     *   ring.window(first, second);
+     *   float sum = thrust::reduce(muse::get<1>(first).begin(), muse::get<1>(first).end())
+     *             + thrust::reduce(muse::get<1>(second).begin(), muse::get<1>(second).end());
+     *   float mean = sum / (first.size() + second.size());
+     *
+     *   \endcode
+     */
+    template<typename T0, typename T1, typename T2, typename T3, typename T4,
+             typename T5, typename T6, typename T7, typename T8, typename T9>
+    class ring_multiarray
+    {
+
+    private:
+        typedef host_multiarray<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> storage_type;
+        typedef multiarray_view<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> columns_type;
+
+    public:
+        typedef std::size_t size_type;
+
+        /*!
+         *  Read-only view of a contiguous part of the live rows
+         */
+        typedef multiarray_view<typename muse::detail::ring_const_element<T0>::type,
+                                typename muse::detail::ring_const_element<T1>::type,
+                                typename muse::detail::ring_const_element<T2>::type,
+                                typename muse::detail::ring_const_element<T3>::type,
+                                typename muse::detail::ring_const_element<T4>::type,
+                                typename muse::detail::ring_const_element<T5>::type,
+                                typename muse::detail::ring_const_element<T6>::type,
+                                typename muse::detail::ring_const_element<T7>::type,
+                                typename muse::detail::ring_const_element<T8>::type,
+                                typename muse::detail::ring_const_element<T9>::type> view_type;
+
+        /*!
+         *  This constructor creates an empty \p ring_multiarray holding up to n rows
+         *  \param n capacity expressed in rows
+         */
+        explicit ring_multiarray(size_type n)
+            : storage(n), head(0), tail(0)
+        {
+            // Both threads reach the containers through views taken once, never through storage
+            muse::detail::ring_view_rows f = { 0, n };
+            muse::detail::for_each_column_pair<0>(f, storage, columns);
+        }
+
+        /*!
+         *  Returns the maximum number of live rows
+         *  \return capacity expressed in rows
+         */
+        size_type capacity(void) const { return columns.size(); }
+
+        /*!
+         *  Returns the number of live rows. Exact in the producer and in the
+         *  consumer thread, any other thread gets a value that may be out of date
+         *  \return number of live rows
+         */
+        size_type size(void) const
+        {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        bool empty(void) const { return 0 == size(); }
+
+        bool full(void) const { return capacity() == size(); }
+
+        /*!
+         *  Appends count rows of rows starting at row first, as many as fit.
+         *  Called by the producer thread only.
+         *  \param rows  any multiarray with the same component types, e.g. \p host_multiarray
+         *               or \p device_multiarray
+         *  \param first first row of rows to append
+         *  \param count number of rows to append
+         *  \return number of rows appended, less than count when the ring is full
+         */
+        template<class Array>
+        size_type push_rows(const Array& rows, size_type first, size_type count)
+        {
+            MUSE_SCOPED_TIMER("ring_multiarray::push_rows");
+
+            const size_type t = tail.load(std::memory_order_relaxed);
+            const size_type free = capacity() - (t - head.load(std::memory_order_acquire));
+            if (count > free)
+            {
+                count = free;
+            }
+
+            copy_in(rows, first, count, t);
+
+            // Publishes the rows to the consumer
+            tail.store(t + count, std::memory_order_release);
+            return count;
+        }
+
+        /*!
+         *  Appends all rows of rows, as many as fit.
+         *  Called by the producer thread only.
+         *  \param rows any multiarray with the same component types
+         *  \return number of rows appended
+         */
+        template<class Array>
+        size_type push_rows(const Array& rows)
+        {
+            return push_rows(rows, 0, rows.size());
+        }
+
+        /*!
+         *  Appends all rows of rows, dropping the oldest rows when the ring is
+         *  full, so the ring keeps a sliding window of the last capacity rows.
+         *  Moves the head, so it must not run concurrently with a consumer.
+         *  \param rows any multiarray with the same component types
+         */
+        template<class Array>
+        void push_rows_overwrite(const Array& rows)
+        {
+            MUSE_SCOPED_TIMER("ring_multiarray::push_rows");
+
+            size_type first = 0;
+            size_type count = rows.size();
+
+            // Rows that would be overwritten in the same batch are skipped
+            if (count > capacity())
+            {
+                first = count - capacity();
+                count = capacity();
+            }
+
+            const size_type t = tail.load(std::memory_order_relaxed);
+            const size_type h = head.load(std::memory_order_relaxed);
+            if (t - h + count > capacity())
+            {
+                head.store(t + count - capacity(), std::memory_order_relaxed);
+            }
+
+            copy_in(rows, first, count, t);
+            tail.store(t + count, std::memory_order_release);
+        }
+
+        /*!
+         *  Removes n oldest rows. Called by the consumer thread only.
+         *  \param n number of rows to remove, at most size()
+         */
+        void pop_rows(size_type n)
+        {
+            // Releases the slots to the producer once all reads of them are done
+            head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        }
+
+        /*!
+         *  Returns live rows of N-th component, oldest first, as two views.
+         *  The second view is empty unless the live rows wrap around.
+         *  \tparam N component id
+         *  \return first and second part of the live rows
+         */
+        template<int N>
+        std::pair<column_view<const typename multiarray_element<N, storage_type>::type::value_type>,
+                  column_view<const typename multiarray_element<N, storage_type>::type::value_type> >
+            spans(void) const
+        {
+            typedef column_view<const typename multiarray_element<N, storage_type>::type::value_type> span_type;
+
+            const typename multiarray_element<N, storage_type>::type::value_type* data = muse::get<N>(columns).data();
+
+            size_type p, first_count, second_count;
+            live_parts(p, first_count, second_count);
+
+            return std::make_pair(span_type(data + p, first_count), span_type(data, second_count));
+        }
+
+        /*!
+         *  Returns live rows of all components, oldest first, as two views.
+         *  The second view is empty unless the live rows wrap around.
+         *  \param first  output, older part of the live rows
+         *  \param second output, newer part of the live rows
+         */
+        void window(view_type& first, view_type& second) const
+        {
+            size_type p, first_count, second_count;
+            live_parts(p, first_count, second_count);
+
+            muse::detail::ring_view_rows f = { p, first_count };
+            muse::detail::for_each_column_pair<0>(f, columns, first);
+
+            muse::detail::ring_view_rows s = { 0, second_count };
+            muse::detail::for_each_column_pair<0>(s, columns, second);
+        }
+
+    private:
+        ring_multiarray(const ring_multiarray&);
+        ring_multiarray& operator=(const ring_multiarray&);
+
+        // Copies rows to the free slots following tail counter t
+        template<class Array>
+        void copy_in(const Array& rows, size_type first, size_type count, size_type t)
+        {
+            if (0 == count)
+            {
+                return;
+            }
+
+            const size_type p = t % capacity();
+            const size_type first_count = count < capacity() - p ? count : capacity() - p;
+
+            muse::detail::ring_copy_rows f = { first, first_count, p };
+            muse::detail::for_each_column_pair<0>(f, rows, columns);
+
+            muse::detail::ring_copy_rows s = { first + first_count, count - first_count, 0 };
+            muse::detail::for_each_column_pair<0>(s, rows, columns);
+        }
+
+        // Position of the oldest live row and sizes of both parts of the live rows
+        void live_parts(size_type& p, size_type& first_count, size_type& second_count) const
+        {
+            const size_type h = head.load(std::memory_order_acquire);
+            const size_type n = tail.load(std::memory_order_acquire) - h;
+
+            p = capacity() ? h % capacity() : 0;
+            first_count = n < capacity() - p ? n : capacity() - p;
+            second_count = n - first_count;
+        }
+
+        storage_type storage;
+        columns_type columns;
+
+        // Counters of pushed and popped rows, on separate cache lines
+        std::atomic<size_type> head;
+        char head_padding[64];
+        std::atomic<size_type> tail;
+
+    }; // end class ring_multiarray
+
+
+} // end namespace muse
@@ -0,0 +1,200 @@
+/*! \file small_multiarray.h
+ *  \brief A structure of arrays keeping a small number of elements inline, in the "host" memory space.
+ */
+#pragma once
+
+#include <muse/multiarray/detail/common.h>
+#include <muse/multiarray/detail/small_multiarray.inl>
+#include <muse/multiarray/detail/concatenate.inl>
+#include <muse/multiarray/detail/column_loop.inl>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Getter function that returns reference to N-th container
+     *   of \p small_multiarray
+     *
+     *   \tparam N container id within \p small_multiarray structure of containers
+     *   \tparam Capacity number of elements stored inline
+     *   \tparam HT head type
+     *   \tparam TT tail type
+     *
+     *   \param  t reference to \p small_multiarray instance
+     *   \return reference to N-th container
+     *
+     *   \code
+     *   #include <muse/multiarray/small_multiarray.h>
+     *
+     *   muse::small_multiarray<8, int, float> x(4);
+     *
+     *   muse::small_vector<int, 8>   & v0 = muse::get<0>(x);
+     *   muse::small_vector<float, 8> & v1 = muse::get<1>(x);
+     *
+     *   \endcode
+     */
+    template<int N, int Capacity, class HT, class TT>
+      inline
+        typename muse::access_traits<typename multiarray_element<N, muse::detail::cons_small<Capacity, HT, TT> >::type >::reference_type
+          get(muse::detail::cons_small<Capacity, HT, TT>& t);
+
+
+    /*!
+     *   Getter function that returns const reference to N-th container
+     *   of \p small_multiarray
+     *
+     *   \tparam N container id within \p small_multiarray structure of containers
+     *   \tparam Capacity number of elements stored inline
+     *   \tparam HT head type
+     *   \tparam TT tail type
+     *
+     *   \param  t const reference to \p small_multiarray instance
+     *   \return const reference to N-th container
+     */
+    template<int N, int Capacity, class HT, class TT>
+      inline
+        typename muse::access_traits<typename multiarray_element<N, muse::detail::cons_small<Capacity, HT, TT> >::type >::const_reference_type
+          get(const muse::detail::cons_small<Capacity, HT, TT>& t);
+
+
+    /*!
+     *   Structure of arrays basing on \p small_vector.
+     *   Max number of arrays reduced to 10
+     *
+     *   Up to Capacity elements of every container are stored inside the
+     *   object, so creating and filling a small \p small_multiarray does not
+     *   allocate. Growing past Capacity moves all containers to the heap.
+     *   The interface follows \p host_multiarray, so code using \p get,
+     *   \p resize and \p size switches between them with a typedef.
+     *   Unlike \p host_multiarray it is copyable, copies of inline arrays are
+     *   cheap and allow storing them by value in other containers.
+     *
+     *   \tparam Capacity number of elements stored inline
+     *
+     *   \code
+     *   #include <muse/multiarray/small_multiarray.h>
+     *
+     *   // neighbor list of a cell, index and distance
+     *   typedef muse::small_multiarray<16, int, float> NeighborList;
+     *
+     *   int main()
+     *   {
+     *     NeighborList list;
+     *
+     *     // no allocation up to 16 elements
+     *     list.resize(5);
+     *     muse::get<0>(list)[0] = 42;
+     *     muse::get<1>(list)[0] = 0.5f;
+     *
+     *     // moved to heap
+     *     list.resize(100);
+     *   }
+     *
+     *   \endcode
+     */
+    template<int Capacity,
+             typename T0, typename T1, typename T2, typename T3, typename T4,
+             typename T5, typename T6, typename T7, typename T8, typename T9>
+    class small_multiarray
+        : public muse::detail::map_multiarray_to_cons_small<Capacity, T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>::type
+    {
+
+    private:
+        typedef typename muse::detail::map_multiarray_to_cons_small<Capacity, T0, T1, T2, T3, T4, T5, T6, T7, T8, T9>::type inherited;
+        typedef typename inherited::size_type size_type;
+
+    public:
+
+        static const int inline_capacity = Capacity;
+
+        /*!
+         *  This constructor creates an empty \p small_multiarray
+         */
+        small_multiarray(void)
+            : inherited() {};
+
+        /*!
+         *  This constructor creates a \p small_multiarray with n elements
+         *  \param n number of elements to initially create
+         */
+        explicit small_multiarray(size_type n)
+            : inherited(n) {};
+
+        /*!
+         *  Default destructor
+         */
+        ~small_multiarray(void) {};
+
+        /*!
+         *  Resizes each of the \p small_multiarray component uniformly to contain n elements
+         *  \param n new \p small_multiarray size expressed in elements
+         */
+        void resize(size_type n)
+        {
+            MUSE_SCOPED_TIMER("small_multiarray::resize");
+            muse::detail::record_resize();
+            inherited::resize(n);
+        }
+
+        /*!
+         *  Returns the number of elements
+         *  \return number of elements
+         */
+        size_type size(void) const { return inherited::size(); }
+
+        /*!
+         *  This method resizes this \p small_multiarray to 0
+         */
+        void clear(void) { inherited::resize(0); }
+
+        /*!
+         *  This method returns true if size() == 0
+         *  \return true if size() == 0; false, otherwise
+         */
+        bool empty(void) const { return 0 == inherited::size(); }
+
+        /*!
+         *  This method returns true while elements are stored inside the object
+         *  \return false once the \p small_multiarray has grown past Capacity
+         */
+        bool is_inline(void) const { return inherited::get_head().is_inline(); }
+
+        /*!
+         *  Appends all elements of other at the end of this \p small_multiarray.
+         *  \param other \p small_multiarray to append, may be this one
+         */
+        void append(const small_multiarray& other)
+        {
+            MUSE_SCOPED_TIMER("small_multiarray::append");
+            muse::detail::append_rows_serial(*this, other);
+        }
+
+        /*!
+         *  Returns memory held by all components of this \p small_multiarray,
+         *  inline storage is counted as allocated
+         *  \return sum of element bytes and of allocated bytes
+         */
+        footprint memory_footprint(void) const
+        {
+            return muse::detail::array_footprint(*this);
+        }
+
+    }; // end class small_multiarray
+
+
+    /*! \cond
+     */
+    template<int Capacity>
+    class small_multiarray<Capacity, null_type, null_type, null_type, null_type, null_type,
+                           null_type, null_type, null_type, null_type, null_type>
+    {
+    public:
+        typedef null_type inherited;
+    };
+    /*! \endcond
+     */
+
+
+} // end namespace muse
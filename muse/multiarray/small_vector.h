@@ -0,0 +1,191 @@
+/*! \file small_vector.h
+ *  \brief Container keeping a small number of elements inline, used by small_multiarray.
+ */
+#pragma once
+
+#include <thrust/host_vector.h>
+#include <thrust/memory.h>
+#include <muse/multiarray/detail/instrumentation.inl>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+
+namespace muse
+{
+
+
+    /*!
+     *   Container storing up to Capacity elements inside the object,
+     *   without heap allocation. Growing past Capacity moves the elements
+     *   to a \p thrust::host_vector, they stay there when the container
+     *   shrinks again, so a container oscillating around Capacity does not
+     *   copy its elements back and forth.
+     *
+     *   Iterators are plain pointers, so Thrust algorithms dispatch to the
+     *   host backend.
+     *
+     *   \tparam T        element type
+     *   \tparam Capacity number of elements stored inline, at least 1
+     *
+     *   \code
+     *   #include <muse/multiarray/small_vector.h>
+     *
+     *   muse::small_vector<int, 8> neighbors;
+     *
+     *   neighbors.push_back(3);   // inline
+     *   neighbors.resize(100);    // moved to heap
+     *
+     *   \endcode
+     */
+    template<typename T, int Capacity>
+    class small_vector
+    {
+
+    public:
+        typedef T value_type;
+        typedef std::size_t size_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T* iterator;
+        typedef const T* const_iterator;
+
+        static const int inline_capacity = Capacity;
+
+        /*!
+         *  This constructor creates an empty \p small_vector
+         */
+        small_vector(void)
+            : n(0), on_heap(false) {}
+
+        /*!
+         *  This constructor creates a \p small_vector with count value-initialized elements
+         *  \param count number of elements to initially create
+         */
+        explicit small_vector(size_type count)
+            : n(0), on_heap(false) { resize(count); }
+
+        small_vector(const small_vector& other)
+            : n(0), on_heap(false) { assign(other.begin(), other.end()); }
+
+        small_vector& operator=(const small_vector& other)
+        {
+            if (this != &other)
+            {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        /*!
+         *  Replaces content with elements of [first, last)
+         */
+        template<class InputIterator>
+        void assign(InputIterator first, InputIterator last)
+        {
+            resize(static_cast<size_type>(std::distance(first, last)));
+            std::copy(first, last, begin());
+        }
+
+        /*!
+         *  Resizes container to count elements, new elements are copies of value
+         *  \param count new size
+         *  \param value value of new elements
+         */
+        void resize(size_type count, const value_type& value = value_type())
+        {
+            if (on_heap)
+            {
+                heap.resize(count, value);
+            }
+            else if (count > size_type(Capacity))
+            {
+                spill(count);
+                heap.resize(count, value);
+            }
+            else if (count > n)
+            {
+                std::fill(buffer + n, buffer + count, value);
+            }
+            n = count;
+        }
+
+        /*!
+         *  Makes room for count elements without changing size
+         *  \param count number of elements
+         */
+        void reserve(size_type count)
+        {
+            if (on_heap)
+            {
+                heap.reserve(count);
+            }
+            else if (count > size_type(Capacity))
+            {
+                spill(count);
+            }
+        }
+
+        void push_back(const value_type& value)
+        {
+            if (!on_heap && n == size_type(Capacity))
+            {
+                spill(2 * n);
+            }
+            resize(n + 1, value);
+        }
+
+        void pop_back(void) { resize(n - 1); }
+
+        void clear(void) { resize(0); }
+
+        size_type size(void) const { return n; }
+
+        bool empty(void) const { return 0 == n; }
+
+        size_type capacity(void) const { return on_heap ? heap.capacity() : size_type(Capacity); }
+
+        /*!
+         *  Returns true while elements are stored inside the object
+         *  \return false once the container has grown past Capacity
+         */
+        bool is_inline(void) const { return !on_heap; }
+
+        pointer data(void) { return on_heap ? thrust::raw_pointer_cast(heap.data()) : buffer; }
+        const_pointer data(void) const { return on_heap ? thrust::raw_pointer_cast(heap.data()) : buffer; }
+
+        reference operator[](size_type i) { return data()[i]; }
+        const_reference operator[](size_type i) const { return data()[i]; }
+
+        iterator begin(void) { return data(); }
+        iterator end(void) { return data() + n; }
+        const_iterator begin(void) const { return data(); }
+        const_iterator end(void) const { return data() + n; }
+
+    private:
+        // Moves inline elements to heap storage with room for count elements
+        void spill(size_type count)
+        {
+            heap.reserve(count);
+            heap.resize(n);
+            std::copy(buffer, buffer + n, heap.begin());
+            on_heap = true;
+
+            muse::detail::record_allocation(heap.capacity() * sizeof(T));
+            muse::detail::record_bytes_moved(n * sizeof(T));
+        }
+
+        // Capacity has to be positive
+        typedef char capacity_check[Capacity > 0 ? 1 : -1];
+
+        size_type n;
+        bool on_heap;
+        T buffer[Capacity];
+        thrust::host_vector<T> heap;
+
+    }; // end class small_vector
+
+
+} // end namespace muse
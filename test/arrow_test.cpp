@@ -0,0 +1,193 @@
+/*! \file arrow_test.cpp
+ *  \brief Round trip of host_multiarray through the Arrow C data interface.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s\n", what);
+            ++failures;
+        }
+    }
+
+
+    typedef muse::host_multiarray<float, int, muse::packed_bool, unsigned char, double> array_type;
+    typedef muse::multiarray_view<const float, const int> view_type;
+
+    const std::size_t rows = 100;
+
+
+    void fill(array_type& a)
+    {
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            muse::get<0>(a)[i] = 0.5f * i;
+            muse::get<1>(a)[i] = -static_cast<int>(i);
+            muse::get<2>(a)[i] = 0 == i % 3;
+            muse::get<3>(a)[i] = static_cast<unsigned char>(i);
+            muse::get<4>(a)[i] = 2.0 * i;
+        }
+    }
+
+
+    void export_format(void)
+    {
+        array_type a(rows);
+        fill(a);
+
+        ArrowSchema schema;
+        ArrowArray array;
+        muse::export_arrow(a, &schema, &array);
+
+        check(0 == std::strcmp(schema.format, "+s") && 5 == schema.n_children, "struct schema");
+        check(0 == std::strcmp(schema.children[0]->format, "f"), "float format");
+        check(0 == std::strcmp(schema.children[1]->format, "i"), "int format");
+        check(0 == std::strcmp(schema.children[2]->format, "b"), "packed_bool format");
+        check(0 == std::strcmp(schema.children[3]->format, "C"), "unsigned char format");
+        check(0 == std::strcmp(schema.children[4]->format, "g"), "double format");
+        check(0 == std::strcmp(schema.children[3]->name, "3"), "default names");
+        check(static_cast<int64_t>(rows) == array.length, "length");
+
+        // Zero copy, later writes copy the container and keep exported data
+        const array_type& c = a;
+        check(array.children[1]->buffers[1] == &muse::get<1>(c)[0], "buffer shared");
+        muse::get<1>(a)[1] = 12345;
+        check(-1 == static_cast<const int*>(array.children[1]->buffers[1])[1], "export unaffected by writes");
+
+        const unsigned char* bits = static_cast<const unsigned char*>(array.children[2]->buffers[1]);
+        bool bitmap = true;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            bitmap = bitmap && (0 != ((bits[i / 8] >> (i % 8)) & 1)) == (0 == i % 3);
+        }
+        check(bitmap, "packed_bool as Arrow bitmap");
+
+        // Column count and types have to match the view
+        view_type v;
+        check(!muse::import_arrow(&schema, &array, v), "import of mismatching struct fails");
+
+        array.release(&array);
+        schema.release(&schema);
+        check(0 == array.release && 0 == schema.release, "release clears callbacks");
+    }
+
+
+    void round_trip(void)
+    {
+        muse::host_multiarray<float, int> a(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            muse::get<0>(a)[i] = static_cast<float>(i);
+            muse::get<1>(a)[i] = static_cast<int>(i * i);
+        }
+
+        const char* names[] = { "x", "id" };
+        ArrowSchema schema;
+        ArrowArray array;
+        muse::export_arrow(a, &schema, &array, names);
+        check(0 == std::strcmp(schema.children[1]->name, "id"), "names");
+
+        view_type v;
+        check(muse::import_arrow(&schema, &array, v), "import");
+        check(rows == v.size(), "imported size");
+        const muse::host_multiarray<float, int>& c = a;
+        bool equal = &muse::get<0>(v)[0] == &muse::get<0>(c)[0];
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            equal = equal && muse::get<0>(v)[i] == muse::get<0>(c)[i] && muse::get<1>(v)[i] == muse::get<1>(c)[i];
+        }
+        check(equal, "imported values");
+
+        muse::multiarray_view<const int, const int> wrong;
+        check(!muse::import_arrow(&schema, &array, wrong), "import with wrong type fails");
+
+        // Slice of the struct array
+        array.offset = 2;
+        array.length = 5;
+        check(muse::import_arrow(&schema, &array, v) && 5 == v.size() && 4 == muse::get<1>(v)[0], "sliced import");
+
+        // Children with own offset, their length excludes it
+        for (int k = 0; k < 2; ++k)
+        {
+            array.children[k]->offset = 3;
+            array.children[k]->length = static_cast<int64_t>(rows) - 3;
+        }
+        check(muse::import_arrow(&schema, &array, v) && 25 == muse::get<1>(v)[0], "sliced import of offset children");
+        array.offset = static_cast<int64_t>(rows) - 7;
+        check(!muse::import_arrow(&schema, &array, v), "slice past child length fails");
+        for (int k = 0; k < 2; ++k)
+        {
+            array.children[k]->offset = 0;
+            array.children[k]->length = static_cast<int64_t>(rows);
+        }
+        array.offset = 0;
+        array.length = static_cast<int64_t>(rows);
+
+        // Nulls are not supported, in the struct nor in children
+        const unsigned char valid[16] = { 0 };
+        array.buffers[0] = valid;
+        array.null_count = 1;
+        check(!muse::import_arrow(&schema, &array, v), "struct with nulls fails");
+        array.buffers[0] = 0;
+        array.null_count = 0;
+
+        // Released structures are rejected
+        void (*release)(ArrowArray*) = array.release;
+        array.release = 0;
+        check(!muse::import_arrow(&schema, &array, v), "released array fails");
+        array.release = release;
+
+        // Child moved out stays valid after the parent and the multiarray are gone
+        ArrowArray child = *array.children[1];
+        array.children[1]->release = 0;
+        array.release(&array);
+        a.resize(0);
+        check(81 == static_cast<const int*>(child.buffers[1])[9], "moved child outlives parent");
+        child.release(&child);
+        check(0 == child.release, "moved child released");
+
+        schema.release(&schema);
+    }
+
+
+    void empty(void)
+    {
+        array_type a;
+        ArrowSchema schema;
+        ArrowArray array;
+        muse::export_arrow(a, &schema, &array);
+        check(0 == array.length && 0 != array.children[0]->buffers[1], "empty export has data buffers");
+        array.release(&array);
+        schema.release(&schema);
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    test::export_format();
+    test::round_trip();
+    test::empty();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+/*! \file async_test.cpp
+ *  \brief Work-stealing executor, dependency graphs and asynchronous multiarray operations.
+ */
+
+#include <muse/multiarray.h>
+#include <muse/multiarray/async.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s\n", what);
+            ++failures;
+        }
+    }
+
+
+    struct count_call
+    {
+        std::atomic<int>* calls;
+
+        void operator()(void) const { ++*calls; }
+    };
+
+    // Appends id to a sequence, checks dependencies ran in order
+    struct record_step
+    {
+        std::vector<int>* steps;
+        int id;
+
+        void operator()(void) const { steps->push_back(id); }
+    };
+
+    struct throw_error
+    {
+        void operator()(void) const { throw std::runtime_error("task failed"); }
+    };
+
+
+    void many_tasks(muse::async::executor& exec)
+    {
+        std::atomic<int> calls(0);
+        std::vector<muse::async::future> futures;
+        for (int i = 0; i < 1000; ++i)
+        {
+            count_call f = { &calls };
+            futures.push_back(muse::async::run(exec, f));
+        }
+        muse::async::when_all(futures.begin(), futures.end()).wait();
+        check(1000 == calls, "every task runs once");
+    }
+
+
+    void chain(muse::async::executor& exec)
+    {
+        std::vector<int> steps;
+        record_step first = { &steps, 0 };
+        muse::async::future f = muse::async::run(exec, first);
+        for (int i = 1; i < 100; ++i)
+        {
+            record_step next = { &steps, i };
+            f = i % 2 ? f.then(next) : muse::async::run(exec, next, f);
+        }
+        f.wait();
+        check(f.ready(), "chain ready after wait");
+
+        bool ordered = 100 == steps.size();
+        for (std::size_t i = 0; ordered && i < steps.size(); ++i)
+        {
+            ordered = static_cast<int>(i) == steps[i];
+        }
+        check(ordered, "chain runs in dependency order");
+    }
+
+
+    void join(muse::async::executor& exec)
+    {
+        std::atomic<int> calls(0);
+        count_call f = { &calls };
+        muse::async::future both = muse::async::when_all(muse::async::run(exec, f), muse::async::run(exec, f));
+
+        std::vector<int> steps;
+        record_step after = { &steps, 0 };
+        both.then(after).wait();
+        check(2 == calls, "when_all waits for both");
+
+        check(muse::async::when_all(muse::async::future(), muse::async::future()).ready(), "when_all of ready futures");
+    }
+
+
+    void failure(muse::async::executor& exec)
+    {
+        std::atomic<int> calls(0);
+        count_call f = { &calls };
+
+        muse::async::future failed = muse::async::run(exec, throw_error());
+        muse::async::future dependant = failed.then(f);
+        muse::async::future joined = muse::async::when_all(dependant, muse::async::run(exec, f));
+
+        bool thrown = false;
+        try
+        {
+            joined.wait();
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, "wait rethrows exception of a dependency");
+        check(1 == calls, "dependant of a failed task does not run");
+
+        // Failure of a finished future is passed on as well
+        thrown = false;
+        try
+        {
+            muse::async::run(exec, f, failed).wait();
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, "finished failed future fails its dependant");
+
+        // Pool keeps working
+        many_tasks(exec);
+    }
+
+
+    typedef muse::host_multiarray<int, float, muse::packed_bool> host_array;
+    typedef muse::device_multiarray<int, float> device_array;
+
+    void operations(muse::async::executor& exec)
+    {
+        const std::size_t n = 10000;
+        host_array a(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            muse::get<0>(a)[i] = static_cast<int>((i * 7919) % n);
+            muse::get<1>(a)[i] = static_cast<float>(i);
+            muse::get<2>(a)[i] = 0 == i % 3;
+        }
+
+        thrust::host_vector<bool> keep(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            keep[i] = 0 == i % 2;
+        }
+
+        // sort, then compact, then copy to the device and back
+        device_array d;
+        muse::host_multiarray<int, float> back;
+        muse::async::future sorted = muse::async::sort_by_column<0>(exec, a);
+        muse::async::future compacted = muse::async::compact(exec, a, keep, sorted);
+        muse::async::future to_device = muse::async::copy(exec, static_cast<const host_array&>(a), d, compacted);
+        muse::async::future to_host = muse::async::copy(exec, static_cast<const device_array&>(d), back, to_device);
+        to_host.wait();
+
+        // Keys are a permutation of [0, n), kept are the even positions after sort
+        const host_array& c = a;
+        check(n / 2 == c.size() && n / 2 == back.size(), "compacted size");
+        bool sorted_rows = true;
+        bool copied = true;
+        for (std::size_t i = 0; i < c.size(); ++i)
+        {
+            const int key = static_cast<int>(2 * i);
+            const std::size_t row = (static_cast<std::size_t>(key) * 7679) % n;
+            sorted_rows = sorted_rows && key == muse::get<0>(c)[i];
+            sorted_rows = sorted_rows && static_cast<float>(row) == muse::get<1>(c)[i];
+            sorted_rows = sorted_rows && (0 == row % 3) == muse::get<2>(c)[i];
+            copied = copied && muse::get<0>(c)[i] == muse::get<0>(back)[i] && muse::get<1>(c)[i] == muse::get<1>(back)[i];
+        }
+        check(sorted_rows, "sort and compact keep rows together");
+        check(copied, "copy to device and back");
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    muse::async::executor exec(4);
+
+    test::many_tasks(exec);
+    test::chain(exec);
+    test::join(exec);
+    test::failure(exec);
+    test::operations(exec);
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/*! \file concatenate_test.cpp
+ *  \brief Concatenation below and above the parallel copy threshold and merging of sorted multiarrays.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what, std::size_t rows)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s, %lu rows\n", what, static_cast<unsigned long>(rows));
+            ++failures;
+        }
+    }
+
+
+    // row id, value, bit-packed, flag
+    typedef muse::host_multiarray<long, double, muse::bit_packed<int, 5>, muse::packed_bool> array_type;
+
+    double value(long i) { return 0.25 * i; }
+    int packed(long i) { return static_cast<int>(i % 32) - 16; }
+    bool flag(long i) { return 0 == i % 3; }
+
+
+    void fill(array_type& a, long first, long step)
+    {
+        for (std::size_t r = 0; r < a.size(); ++r)
+        {
+            const long i = first + step * static_cast<long>(r);
+            muse::get<0>(a)[r] = i;
+            muse::get<1>(a)[r] = value(i);
+            muse::get<2>(a)[r] = packed(i);
+            muse::get<3>(a)[r] = flag(i);
+        }
+    }
+
+
+    // Row r holds the values of row id first + step * r
+    bool rows(const array_type& a, long first, long step)
+    {
+        bool ok = true;
+        for (std::size_t r = 0; ok && r < a.size(); ++r)
+        {
+            const long i = first + step * static_cast<long>(r);
+            ok = i == muse::get<0>(a)[r] && value(i) == muse::get<1>(a)[r];
+            ok = ok && packed(i) == muse::get<2>(a)[r] && flag(i) == muse::get<3>(a)[r];
+        }
+        return ok;
+    }
+
+
+    void concatenate(std::size_t n)
+    {
+        // Part sizes not multiple of a packed word
+        array_type a(n / 3), b(n / 3 + 7), c(n - 2 * (n / 3) - 7);
+        fill(a, 0, 1);
+        fill(b, static_cast<long>(a.size()), 1);
+        fill(c, static_cast<long>(a.size() + b.size()), 1);
+
+        const array_type* parts[] = { &a, &b, &c };
+        array_type all;
+        muse::concatenate(parts, parts + 3, all);
+        check(n == all.size() && rows(all, 0, 1), "concatenate", n);
+
+        array_type list;
+        muse::concatenate({a, b, c}, list);
+        check(n == list.size() && rows(list, 0, 1), "concatenate braced list", n);
+    }
+
+
+    void merge(std::size_t n)
+    {
+        // Even and odd row ids
+        array_type a(n / 2), b(n - n / 2);
+        fill(a, 0, 2);
+        fill(b, 1, 2);
+
+        array_type merged;
+        muse::merge_by_column<0>(a, b, merged);
+        check(n == merged.size() && rows(merged, 0, 1), "merge_by_column", n);
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    // Copied on the calling thread
+    test::concatenate(1000);
+    test::merge(1000);
+
+    // Above parallel_copy_rows, a task per container
+    test::concatenate(100000);
+    test::merge(100000);
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+/*! \file dynamic_multiarray_test.cpp
+ *  \brief Run time columns of dynamic_multiarray and sharing them with host_multiarray.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s\n", what);
+            ++failures;
+        }
+    }
+
+
+    const std::size_t rows = 1000;
+
+    int key(std::size_t i) { return static_cast<int>((i * 7919) % rows); }
+
+
+    void columns(void)
+    {
+        muse::dynamic_multiarray table(rows);
+        const std::size_t k = table.add_column("key", muse::dynamic_int32);
+        const std::size_t id = table.add_column<long long>("id");
+        const std::size_t x = table.add_column<double>("x");
+
+        check(3 == table.column_count() && id == table.find("id"), "find column");
+        check(muse::dynamic_int64 == table.type(id), "long long column is int64");
+        check(table.holds<long long>(id) && table.holds<int64_t>(id), "same size integers are one type");
+        check(!table.holds<uint64_t>(id) && !table.holds<int>(id), "other integers are not");
+
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            table.column<int>(k)[i] = key(i);
+            table.column<long long>(id)[i] = static_cast<long long>(i) << 33;
+            table.column<double>(x)[i] = 0.5 * i;
+        }
+
+        check(!table.sort_by_column(3), "sort by missing column fails");
+        check(table.sort_by_column(k), "sort by key");
+
+        // Keys are a permutation of [0, rows)
+        const muse::dynamic_multiarray& c = table;
+        bool sorted = true;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            const std::size_t row = static_cast<std::size_t>(c.column<long long>(id)[i] >> 33);
+            sorted = sorted && static_cast<int>(i) == c.column<int>(k)[i] && key(row) == static_cast<int>(i);
+            sorted = sorted && 0.5 * row == c.column<double>(x)[i];
+        }
+        check(sorted, "sort keeps rows together");
+
+        thrust::host_vector<bool> keep(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            keep[i] = 0 == i % 4;
+        }
+        table.compact(keep);
+        check(rows / 4 == table.size() && 4 == c.column<int>(k)[1], "compact");
+
+        table.resize(10);
+        check(10 == c.column<double>(x).size() && 36 == c.column<int>(k)[9], "resize");
+    }
+
+
+    typedef muse::host_multiarray<int, long long, muse::packed_bool> host_type;
+
+    void share(void)
+    {
+        host_type a(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            muse::get<0>(a)[i] = key(i);
+            muse::get<1>(a)[i] = -static_cast<long long>(i);
+            muse::get<2>(a)[i] = 0 == i % 3;
+        }
+
+        // Plain int column is shared, long long and packed_bool are copied
+        muse::dynamic_multiarray table(a);
+        const host_type& c = a;
+        check(3 == table.column_count() && rows == table.size(), "shared size");
+        check(&static_cast<const muse::dynamic_multiarray&>(table).column<int>(0)[0] == &muse::get<0>(c)[0], "int column shared");
+        check(table.holds<long long>(1) && table.holds<bool>(2), "column types");
+
+        // Writes of one side leave the other alone
+        table.column<int>(0)[0] = -1;
+        check(key(0) == muse::get<0>(c)[0], "write to shared column copies");
+
+        // Shrinking copies only the kept rows of shared columns
+        muse::dynamic_multiarray shared(a);
+        shared.resize(10);
+        check(10 == shared.column<int>(0).size() && rows == muse::get<0>(c).size(), "resize of shared column");
+        check(key(9) == shared.column<int>(0)[9] && key(999) == muse::get<0>(c)[999], "resize keeps values");
+
+        // Back to a host_multiarray; the long long column is copied, int one shared
+        muse::host_multiarray<int, long long, bool> b;
+        check(table.share_to(b), "share to long long container");
+        check(rows == b.size(), "shared to size");
+        bool equal = true;
+        for (std::size_t i = 1; i < rows; ++i)
+        {
+            equal = equal && key(i) == muse::get<0>(b)[i] && -static_cast<long long>(i) == muse::get<1>(b)[i];
+            equal = equal && (0 == i % 3) == muse::get<2>(b)[i];
+        }
+        check(equal, "shared to values");
+
+        muse::host_multiarray<int, unsigned long long, bool> wrong;
+        check(!table.share_to(wrong), "share to other signedness fails");
+        check(0 == wrong.size(), "failed share leaves multiarray alone");
+
+        // Views need the storage type
+        muse::dynamic_multiarray ids(rows);
+        ids.add_column<int>("key");
+        ids.add_column<long long>("id");
+        ids.column<long long>(1)[5] = -5;
+        muse::multiarray_view<const int, const long long> wrong_view;
+        muse::multiarray_view<const int, const int64_t> v;
+        check(!ids.view(wrong_view) || std::is_same<long long, int64_t>::value, "view of other integer type fails");
+        check(ids.view(v) && -5 == muse::get<1>(v)[5], "view");
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    test::columns();
+    test::share();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
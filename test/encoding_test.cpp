@@ -0,0 +1,204 @@
+/*! \file encoding_test.cpp
+ *  \brief Round trip and filter tests of packed encodings at sizes around chunk and block boundaries.
+ */
+
+#include <muse/multiarray/encoding.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what, int bits, std::size_t n, std::size_t i)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s bits %d n %lu element %lu\n", what, bits,
+                        static_cast<unsigned long>(n), static_cast<unsigned long>(i));
+            ++failures;
+        }
+    }
+
+
+    // Values spanning the whole range of Bits bits
+    template<typename T, int Bits>
+    T value(std::size_t i)
+    {
+        const muse::packed_word span = muse::detail::low_mask(Bits);
+        const muse::packed_word raw = (i * 0x9E3779B97F4A7C15ull) & span;
+        return muse::detail::field_codec<T, Bits>::decode(raw);
+    }
+
+
+    template<typename T, int Bits>
+    void run(std::size_t n)
+    {
+        muse::bit_packed_vector<T, Bits> packed(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            packed[i] = value<T, Bits>(i);
+        }
+
+        thrust::host_vector<T> plain;
+        muse::unpack(packed, plain);
+        check(plain.size() == n, "unpack size", Bits, n, 0);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            check(plain[i] == value<T, Bits>(i), "unpack", Bits, n, i);
+        }
+
+        const T lo = value<T, Bits>(1) < value<T, Bits>(2) ? value<T, Bits>(1) : value<T, Bits>(2);
+        const T hi = value<T, Bits>(1) < value<T, Bits>(2) ? value<T, Bits>(2) : value<T, Bits>(1);
+
+        muse::bit_vector selection, expected;
+        muse::select_between(packed, lo, hi, selection);
+        muse::select_between(plain, lo, hi, expected);
+        check(selection.size() == n, "select_between size", Bits, n, 0);
+        for (std::size_t w = 0; w < expected.words().size(); ++w)
+        {
+            check(selection.words()[w] == expected.words()[w], "select_between", Bits, n, w * 64);
+        }
+    }
+
+
+    template<typename T, int Bits>
+    void run_sizes(void)
+    {
+        const std::size_t sizes[] = { 0, 1, 63, 64, 65, 129, 1000 };
+        for (std::size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k)
+        {
+            run<T, Bits>(sizes[k]);
+        }
+    }
+
+
+
+    // Words taken by blocks of a frame-of-reference container
+    template<typename T>
+    std::size_t block_words(const muse::for_vector<T>& c)
+    {
+        std::size_t words = 0;
+        for (std::size_t k = 0; k < c.block_headers().size(); ++k)
+        {
+            words += 2 * c.block_headers()[k].width;
+        }
+        return words;
+    }
+
+
+    template<typename T>
+    void check_for(const muse::for_vector<T>& c, const thrust::host_vector<T>& expected, const char* what)
+    {
+        const int bits = static_cast<int>(8 * sizeof(T));
+        check(c.size() == expected.size(), what, bits, expected.size(), 0);
+        for (std::size_t i = 0; i < expected.size() && i < c.size(); ++i)
+        {
+            check(c[i] == expected[i], what, bits, expected.size(), i);
+        }
+        check(c.words().size() <= 2 * block_words(c), "storage of moved blocks reclaimed", bits, expected.size(), 0);
+    }
+
+
+    template<typename T>
+    void run_for(std::size_t n)
+    {
+        const int bits = static_cast<int>(8 * sizeof(T));
+
+        // Random writes widening blocks
+        muse::for_vector<T> packed(n);
+        thrust::host_vector<T> plain(n, T());
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const std::size_t j = (i * 7919) % n;
+            plain[j] = static_cast<T>(value<T, 8 * sizeof(T) < 30 ? 8 * sizeof(T) : 30>(i) / 2);
+            packed[j] = plain[j];
+        }
+        check_for(packed, plain, "random writes");
+
+        // Narrowing writes
+        for (std::size_t i = 0; i < n; i += 3)
+        {
+            plain[i] = T(7);
+            packed[i] = plain[i];
+        }
+        check_for(packed, plain, "narrowing writes");
+
+        // Slots past the end of the last block do not widen it
+        thrust::host_vector<T> base(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            base[i] = static_cast<T>(100 + i % 4);
+        }
+        packed.assign(base.begin(), base.end());
+        bool narrow = true;
+        for (std::size_t k = 0; k < packed.block_headers().size(); ++k)
+        {
+            narrow = narrow && packed.block_headers()[k].width <= 2;
+        }
+        check(narrow, "partial block padded with its minimum", bits, n, 0);
+
+        // Shrinking and growing yield zeros
+        const std::size_t half = n / 2 + 1;
+        packed.resize(half);
+        packed.resize(n + 10);
+        thrust::host_vector<T> grown(n + 10, T());
+        for (std::size_t i = 0; i < half && i < n; ++i)
+        {
+            grown[i] = base[i];
+        }
+        check_for(packed, grown, "resize");
+
+        muse::bit_vector selection, expected;
+        muse::select_between(packed, T(101), T(102), selection);
+        muse::select_between(grown, T(101), T(102), expected);
+        for (std::size_t w = 0; w < expected.words().size(); ++w)
+        {
+            check(selection.words()[w] == expected.words()[w], "frame_of_reference select_between", bits, n, w * 64);
+        }
+    }
+
+
+    template<typename T>
+    void run_for_sizes(void)
+    {
+        const std::size_t sizes[] = { 1, 127, 128, 129, 300, 5000 };
+        for (std::size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k)
+        {
+            run_for<T>(sizes[k]);
+        }
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    test::run_sizes<bool, 1>();
+    test::run_sizes<unsigned, 3>();
+    test::run_sizes<int, 3>();
+    test::run_sizes<unsigned char, 8>();
+    test::run_sizes<int, 12>();
+    test::run_sizes<unsigned, 17>();
+    test::run_sizes<int, 25>();
+    test::run_sizes<unsigned, 26>();
+    test::run_sizes<long long, 40>();
+    test::run_sizes<unsigned long long, 56>();
+    test::run_sizes<long long, 57>();
+    test::run_sizes<unsigned long long, 64>();
+
+    test::run_for_sizes<int>();
+    test::run_for_sizes<unsigned>();
+    test::run_for_sizes<long long>();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
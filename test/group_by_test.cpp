@@ -0,0 +1,167 @@
+/*! \file group_by_test.cpp
+ *  \brief Hash grouping with aggregates and hash join of host_multiarray.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s\n", what);
+            ++failures;
+        }
+    }
+
+
+    // Enough rows for several hash partitions
+    const std::size_t rows = 200000;
+    const int keys = 5003;
+
+    int key(std::size_t i) { return static_cast<int>((i * 7919) % keys); }
+    int value(std::size_t i) { return static_cast<int>(i % 1000) - 500; }
+
+
+    void aggregates(void)
+    {
+        muse::host_multiarray<int, int> in(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            muse::get<0>(in)[i] = key(i);
+            muse::get<1>(in)[i] = value(i);
+        }
+
+        // Expected aggregates per key
+        std::vector<long> count(keys, 0);
+        std::vector<long> sum(keys, 0);
+        std::vector<int> min(keys, 1000);
+        std::vector<int> max(keys, -1000);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            const int k = key(i);
+            const int v = value(i);
+            count[k] += 1;
+            sum[k] += v;
+            if (v < min[k]) min[k] = v;
+            if (max[k] < v) max[k] = v;
+        }
+
+        muse::host_multiarray<int, long, long, int, int> out;
+        muse::group_by<0>(in, out, muse::aggregates<muse::agg::count, muse::agg::sum<1>,
+                                                     muse::agg::min<1>, muse::agg::max<1> >());
+        check(static_cast<std::size_t>(keys) == out.size(), "one group per key");
+
+        std::vector<int> seen(keys, 0);
+        bool equal = true;
+        for (std::size_t g = 0; g < out.size(); ++g)
+        {
+            const int k = muse::get<0>(out)[g];
+            if (k < 0 || keys <= k)
+            {
+                equal = false;
+                continue;
+            }
+            ++seen[k];
+            equal = equal && count[k] == muse::get<1>(out)[g] && sum[k] == muse::get<2>(out)[g];
+            equal = equal && min[k] == muse::get<3>(out)[g] && max[k] == muse::get<4>(out)[g];
+        }
+        check(equal, "aggregates of every group");
+
+        bool once = true;
+        for (int k = 0; k < keys; ++k)
+        {
+            once = once && 1 == seen[k];
+        }
+        check(once, "every key once");
+
+        // Keys only
+        muse::host_multiarray<int> distinct;
+        muse::group_by<0>(in, distinct);
+        check(static_cast<std::size_t>(keys) == distinct.size(), "distinct keys");
+    }
+
+
+    void signed_zero(void)
+    {
+        muse::host_multiarray<float> in(4);
+        muse::get<0>(in)[0] = 0.0f;
+        muse::get<0>(in)[1] = -0.0f;
+        muse::get<0>(in)[2] = 1.0f;
+        muse::get<0>(in)[3] = -0.0f;
+
+        muse::host_multiarray<float, int> out;
+        muse::group_by<0>(in, out, muse::aggregates<muse::agg::count>());
+        check(2 == out.size(), "+0.0 and -0.0 form one group");
+        for (std::size_t g = 0; g < out.size(); ++g)
+        {
+            check((0.0f == muse::get<0>(out)[g]) == (3 == muse::get<1>(out)[g]), "count of the zero group");
+        }
+    }
+
+
+    void join(void)
+    {
+        // event id, cell id
+        muse::host_multiarray<int, int> events(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            muse::get<0>(events)[i] = static_cast<int>(i);
+            muse::get<1>(events)[i] = key(i);
+        }
+
+        // cell id, cell value; every even cell, odd ones have no match
+        muse::host_multiarray<int, float> cells(keys / 2 + 1);
+        for (std::size_t c = 0; c < cells.size(); ++c)
+        {
+            muse::get<0>(cells)[c] = static_cast<int>(2 * c);
+            muse::get<1>(cells)[c] = 0.5f * c;
+        }
+
+        std::size_t expected = 0;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            expected += 0 == key(i) % 2;
+        }
+
+        muse::host_multiarray<int, int, int, float> joined;
+        check(expected == muse::hash_join<1, 0>(events, cells, joined), "number of pairs");
+        check(expected == joined.size(), "joined size");
+
+        bool equal = true;
+        for (std::size_t r = 0; r < joined.size(); ++r)
+        {
+            const std::size_t i = static_cast<std::size_t>(muse::get<0>(joined)[r]);
+            const int k = muse::get<1>(joined)[r];
+            equal = equal && k == key(i) && k == muse::get<2>(joined)[r];
+            equal = equal && 0.25f * k == muse::get<3>(joined)[r];
+        }
+        check(equal, "joined rows");
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    test::aggregates();
+    test::signed_zero();
+    test::join();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/*! \file host_multiarray_test.cpp
+ *  \brief Copy-on-write snapshots and lazy containers of host_multiarray, plain and packed containers.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what, std::size_t i)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s row %lu\n", what, static_cast<unsigned long>(i));
+            ++failures;
+        }
+    }
+
+
+    typedef muse::host_multiarray<int, muse::packed_bool, muse::bit_packed<int, 5>, muse::frame_of_reference<int> > array_type;
+
+    const std::size_t rows = 1000;
+
+    int plain(std::size_t i) { return static_cast<int>(i); }
+    bool flag(std::size_t i) { return 0 != (i & 1); }
+    int packed(std::size_t i) { return static_cast<int>(i % 16) - 8; }
+    int base(std::size_t i) { return 1000 + static_cast<int>(i); }
+
+
+    void fill(array_type& a)
+    {
+        thrust::host_vector<int> v(a.size());
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            muse::get<0>(a)[i] = plain(i);
+            muse::get<1>(a)[i] = flag(i);
+            muse::get<2>(a)[i] = packed(i);
+            v[i] = base(i);
+        }
+        muse::get<3>(a).assign(v.begin(), v.end());
+    }
+
+
+    // Rows below n hold the original values, rows past it zero
+    template<class Array>
+    void check_rows(const Array& a, std::size_t n, const char* what)
+    {
+        check(a.size() == n, what, 0);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const bool old = i < rows;
+            check(muse::get<0>(a)[i] == (old ? plain(i) : 0), what, i);
+            check(muse::get<1>(a)[i] == (old ? flag(i) : false), what, i);
+            check(muse::get<2>(a)[i] == (old ? packed(i) : 0), what, i);
+            check(muse::get<3>(a)[i] == (old ? base(i) : 0), what, i);
+        }
+    }
+
+
+    void snapshot_write(void)
+    {
+        array_type a(rows);
+        fill(a);
+
+        array_type::snapshot_type s = a.snapshot();
+        const array_type& c = a;
+        check(&muse::get<0>(s) == &muse::get<0>(c), "snapshot shares containers", 0);
+
+        muse::get<0>(a)[0] = -1;
+        check(muse::get<0>(c)[0] == -1, "write after snapshot", 0);
+        check(&muse::get<1>(s) == &muse::get<1>(c), "unwritten container stays shared", 0);
+        check_rows(s, rows, "snapshot keeps old content");
+
+        // Detached container is written in place
+        thrust::host_vector<int>& v = muse::get<0>(a);
+        check(&v == &muse::get<0>(a), "second write does not copy", 0);
+    }
+
+
+    // Resize of containers shared with a snapshot keeps only the rows that stay
+    void snapshot_resize(std::size_t n)
+    {
+        array_type a(rows);
+        fill(a);
+
+        array_type::snapshot_type s = a.snapshot();
+        if (n)
+        {
+            a.resize(n);
+        }
+        else
+        {
+            a.clear();
+        }
+
+        check_rows(a, n, "resize after snapshot");
+        check_rows(s, rows, "snapshot after resize");
+    }
+
+
+
+    // Containers are allocated zero-filled at their first access
+    void lazy(void)
+    {
+        array_type a(rows, muse::lazy);
+        check(rows == a.size() && !a.is_materialized<0>() && !a.is_materialized<3>(), "lazy construction", 0);
+
+        a.resize(rows + 10);
+        check(!a.is_materialized<1>() && rows + 10 == a.size(), "resize of lazy multiarray", 0);
+
+        const array_type& c = a;
+        check(0 == muse::get<2>(c)[rows + 9] && rows + 10 == muse::get<2>(c).size(), "const read allocates", 0);
+        check(a.is_materialized<2>() && !a.is_materialized<1>(), "only read container allocated", 0);
+
+        a.resize(rows);
+        fill(a);
+        check_rows(a, rows, "lazy multiarray filled");
+    }
+
+
+    void release(void)
+    {
+        array_type a(rows);
+        fill(a);
+
+        a.release<1>();
+        a.release<3>();
+        check(!a.is_materialized<1>() && !a.is_materialized<3>() && a.is_materialized<0>(), "released containers", 0);
+        check(rows == a.size(), "release keeps size", 0);
+
+        // Released containers follow resize and come back zero-filled
+        a.resize(rows / 2);
+        const array_type& c = a;
+        check(rows / 2 == muse::get<1>(c).size() && !muse::get<1>(c)[0] && !muse::get<1>(c)[rows / 2 - 1], "released container zero-filled", 0);
+        check(rows / 2 == muse::get<3>(c).size() && 0 == muse::get<3>(c)[1], "released packed container zero-filled", 0);
+        check(plain(rows / 2 - 1) == muse::get<0>(c)[rows / 2 - 1], "kept container unchanged", 0);
+
+        // Snapshot keeps a container released afterwards
+        array_type::snapshot_type s = a.snapshot();
+        a.release<0>();
+        check(!a.is_materialized<0>() && plain(7) == muse::get<0>(s)[7], "snapshot of released container", 0);
+    }
+
+
+    void read_first(const array_type* a, const thrust::host_vector<int>** seen)
+    {
+        *seen = &muse::get<0>(*a);
+    }
+
+
+    // Concurrent first reads allocate one container, other containers do not wait
+    void concurrent_read(void)
+    {
+        array_type a(rows, muse::lazy);
+        array_type b(rows, muse::lazy);
+
+        std::vector<const thrust::host_vector<int>*> seen(8);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < seen.size(); ++t)
+        {
+            threads.push_back(std::thread(read_first, t % 2 ? &a : &b, &seen[t]));
+        }
+        for (std::size_t t = 0; t < threads.size(); ++t)
+        {
+            threads[t].join();
+        }
+
+        bool once = true;
+        for (std::size_t t = 2; t < seen.size(); ++t)
+        {
+            once = once && seen[t] == seen[t % 2];
+        }
+        check(once && seen[0] != seen[1], "one container per multiarray", 0);
+        check(a.is_materialized<0>() && !a.is_materialized<1>() && rows == seen[1]->size(), "materialized by readers", 0);
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    test::snapshot_write();
+    test::snapshot_resize(0);
+    test::snapshot_resize(1);
+    test::snapshot_resize(333);
+    test::snapshot_resize(test::rows);
+    test::snapshot_resize(1500);
+    test::lazy();
+    test::release();
+    test::concurrent_read();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/*! \file instrumentation_test.cpp
+ *  \brief Memory footprint of multiarrays, allocation counters and JSON output of timers.
+ *
+ *         Built with MUSE_ENABLE_INSTRUMENTATION defined for the whole program.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s\n", what);
+            ++failures;
+        }
+    }
+
+
+    const std::size_t rows = 1000;
+
+
+    void footprint(void)
+    {
+        muse::host_multiarray<float, double> host(rows);
+        muse::device_multiarray<float, double> device(rows);
+        muse::small_multiarray<4, float, double> small(rows);
+
+        const std::size_t bytes = rows * (sizeof(float) + sizeof(double));
+        check(bytes == host.memory_footprint().size_bytes, "host footprint");
+        check(bytes == device.memory_footprint().size_bytes, "device footprint");
+        check(bytes == small.memory_footprint().size_bytes, "small footprint");
+        check(bytes == muse::memory_footprint(host).size_bytes, "free function footprint");
+        check(rows * sizeof(double) == muse::memory_footprint<1>(device).size_bytes, "container footprint");
+
+        // Released and lazy containers hold nothing, queries do not allocate them
+        host.release<1>();
+        check(rows * sizeof(float) == host.memory_footprint().size_bytes, "released container");
+        check(!host.is_materialized<1>(), "footprint does not allocate");
+
+        muse::host_multiarray<float, double> lazy(rows, muse::lazy);
+        check(0 == lazy.memory_footprint().capacity_bytes && 0 == muse::memory_footprint<0>(lazy).size_bytes, "lazy multiarray");
+
+        // Packed containers count their words
+        muse::host_multiarray<muse::packed_bool> flags(rows);
+        check((rows + 63) / 64 * 8 <= flags.memory_footprint().size_bytes
+              && flags.memory_footprint().size_bytes < rows, "packed footprint");
+    }
+
+
+    void counters(void)
+    {
+        check(muse::instrumentation::enabled(), "instrumentation enabled");
+
+        muse::instrumentation::reset();
+        {
+            muse::host_multiarray<float, int> a(rows);
+            a.resize(2 * rows);
+            check(1 == muse::instrumentation::snapshot().resize_events, "resize events");
+
+            muse::host_multiarray<float, int> b;
+            const muse::host_multiarray<float, int>* parts[] = { &a, &a };
+            muse::concatenate(parts, parts + 2, b);
+        }
+        const muse::instrumentation::statistics s = muse::instrumentation::snapshot();
+        check(s.allocations >= 2 && s.bytes_allocated >= rows * (sizeof(float) + sizeof(int)), "allocations");
+        check(s.bytes_moved >= 4 * rows * (sizeof(float) + sizeof(int)), "bytes moved by concatenate");
+        check(1 == s.timers.count("concatenate") && 1 == s.timers.at("concatenate").calls, "operation timer");
+
+        // Packed containers move their words, not a value per row
+        muse::host_multiarray<muse::packed_bool> flags(rows);
+        muse::host_multiarray<muse::packed_bool> all(2 * rows);
+        const muse::host_multiarray<muse::packed_bool>* parts[] = { &flags, &flags };
+        muse::instrumentation::reset();
+        muse::concatenate(parts, parts + 2, all);
+        check(muse::instrumentation::snapshot().bytes_moved == all.memory_footprint().size_bytes, "bytes moved of packed container");
+    }
+
+
+    void json(void)
+    {
+        muse::instrumentation::reset();
+        {
+            muse::instrumentation::scoped_timer t("quote\" backslash\\ newline\n tab\t bell\a");
+        }
+
+        std::ostringstream os;
+        muse::instrumentation::write_json(os, muse::instrumentation::snapshot());
+        const std::string out = os.str();
+        check(std::string::npos != out.find("\"quote\\\" backslash\\\\ newline\\n tab\\t bell\\u0007\": {\"calls\": 1"), "escaped timer name");
+        check(std::string::npos == out.find('\n') && std::string::npos == out.find('\a'), "no raw control characters");
+        check(0 == out.compare(0, 16, "{\"enabled\": true") && '}' == out[out.size() - 1], "JSON object");
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    test::footprint();
+    test::counters();
+    test::json();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
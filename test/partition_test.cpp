@@ -0,0 +1,149 @@
+/*! \file partition_test.cpp
+ *  \brief Stable partitioning of host_multiarray rows, plain and packed containers.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what, std::size_t buckets)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s, %lu buckets\n", what, static_cast<unsigned long>(buckets));
+            ++failures;
+        }
+    }
+
+
+    // key, row id, bit-packed, flag, frame of reference
+    typedef muse::host_multiarray<int, double, muse::bit_packed<int, 7>, muse::packed_bool,
+                                  muse::frame_of_reference<int> > array_type;
+
+    int key(std::size_t i) { return static_cast<int>((i * 7919) % 100003); }
+    int packed(std::size_t i) { return static_cast<int>(i % 128) - 64; }
+    bool flag(std::size_t i) { return 0 == i % 3; }
+    int base(std::size_t i) { return 5000 + static_cast<int>(i % 1000); }
+
+
+    struct modulo
+    {
+        std::size_t buckets;
+
+        std::size_t operator()(int k) const { return static_cast<std::size_t>(k) % buckets; }
+    };
+
+    // Last row maps past the last bucket
+    struct past_last
+    {
+        std::size_t rows;
+
+        std::size_t operator()(int k) const { return key(rows - 1) == k ? 2 : 0; }
+    };
+
+
+    void fill(array_type& a)
+    {
+        thrust::host_vector<int> v(a.size());
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            muse::get<0>(a)[i] = key(i);
+            muse::get<1>(a)[i] = static_cast<double>(i);
+            muse::get<2>(a)[i] = packed(i);
+            muse::get<3>(a)[i] = flag(i);
+            v[i] = base(i);
+        }
+        muse::get<4>(a).assign(v.begin(), v.end());
+    }
+
+
+    void partition(std::size_t rows, std::size_t buckets)
+    {
+        array_type a(rows);
+        fill(a);
+
+        modulo f = { buckets };
+        const thrust::host_vector<std::size_t> offsets = muse::partition_rows<0>(a, f, buckets);
+        check(buckets + 1 == offsets.size() && 0 == offsets[0] && rows == offsets[buckets], "offsets", buckets);
+
+        const array_type& c = a;
+        bool grouped = true;
+        bool stable = true;
+        bool equal = true;
+        for (std::size_t b = 0; b < buckets && b + 1 < offsets.size(); ++b)
+        {
+            for (std::size_t r = offsets[b]; r < offsets[b + 1]; ++r)
+            {
+                const std::size_t i = static_cast<std::size_t>(muse::get<1>(c)[r]);
+                grouped = grouped && b == f(muse::get<0>(c)[r]);
+                stable = stable && (r == offsets[b] || muse::get<1>(c)[r - 1] < muse::get<1>(c)[r]);
+                equal = equal && key(i) == muse::get<0>(c)[r] && packed(i) == muse::get<2>(c)[r];
+                equal = equal && flag(i) == muse::get<3>(c)[r] && base(i) == muse::get<4>(c)[r];
+            }
+        }
+        check(grouped, "rows in their bucket", buckets);
+        check(stable, "order kept inside a bucket", buckets);
+        check(equal, "rows kept together", buckets);
+    }
+
+
+    void invalid_bucket(std::size_t rows)
+    {
+        array_type a(rows);
+        fill(a);
+
+        past_last f = { rows };
+        check(muse::partition_rows<0>(a, f, 2).empty(), "no offsets for bucket past the last", 2);
+
+        const array_type& c = a;
+        bool unchanged = true;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            unchanged = unchanged && key(i) == muse::get<0>(c)[i] && static_cast<double>(i) == muse::get<1>(c)[i];
+            unchanged = unchanged && packed(i) == muse::get<2>(c)[i] && flag(i) == muse::get<3>(c)[i];
+        }
+        check(unchanged, "array unchanged", 2);
+    }
+
+
+    void empty(void)
+    {
+        array_type a;
+        modulo f = { 1 };
+        const thrust::host_vector<std::size_t> offsets = muse::partition_rows<0>(a, f, 0);
+        check(1 == offsets.size() && 0 == offsets[0], "no buckets", 0);
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    // Few rows, several chunks of write-combining buffers
+    test::partition(1000, 1);
+    test::partition(1000, 16);
+
+    // Many rows and buckets, write-combining and direct scatter
+    test::partition(100000, 16);
+    test::partition(100000, 4096);
+    test::partition(100000, 5000);
+
+    test::invalid_bucket(1000);
+    test::invalid_bucket(100000);
+    test::empty();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/*! \file ring_multiarray_test.cpp
+ *  \brief Ring buffer of rows: wrap-around, overwriting pushes and a producer and consumer thread.
+ */
+
+#include <muse/multiarray.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+
+namespace test
+{
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED %s\n", what);
+            ++failures;
+        }
+    }
+
+
+    // sequence number, derived value
+    typedef muse::ring_multiarray<long, double> ring_type;
+    typedef muse::host_multiarray<long, double> batch_type;
+
+    double derived(long s) { return 0.5 * s; }
+
+    void fill(batch_type& batch, long first)
+    {
+        for (std::size_t i = 0; i < batch.size(); ++i)
+        {
+            muse::get<0>(batch)[i] = first + static_cast<long>(i);
+            muse::get<1>(batch)[i] = derived(first + static_cast<long>(i));
+        }
+    }
+
+
+    // Rows of both parts of a window are the sequence starting at first
+    bool sequence(const ring_type::view_type& a, const ring_type::view_type& b, long first)
+    {
+        bool ok = true;
+        for (std::size_t i = 0; ok && i < a.size() + b.size(); ++i)
+        {
+            const long s = i < a.size() ? muse::get<0>(a)[i] : muse::get<0>(b)[i - a.size()];
+            const double d = i < a.size() ? muse::get<1>(a)[i] : muse::get<1>(b)[i - a.size()];
+            ok = s == first + static_cast<long>(i) && d == derived(s);
+        }
+        return ok;
+    }
+
+
+    // Live rows are the sequence [first, first + size()), spans match the window
+    bool live_rows(const ring_type& ring, long first)
+    {
+        ring_type::view_type a, b;
+        ring.window(a, b);
+        bool ok = a.size() + b.size() == ring.size() && sequence(a, b, first);
+
+        std::pair<muse::column_view<const long>, muse::column_view<const long> > s = ring.spans<0>();
+        ok = ok && s.first.size() == a.size() && s.second.size() == b.size();
+        ok = ok && (a.empty() || s.first.data() == &muse::get<0>(a)[0]);
+        return ok;
+    }
+
+
+    void wrap_around(void)
+    {
+        ring_type ring(10);
+        batch_type batch(7);
+
+        fill(batch, 0);
+        check(7 == ring.push_rows(batch), "push into empty ring");
+        ring.pop_rows(5);
+        fill(batch, 7);
+        check(7 == ring.push_rows(batch), "push wrapping around");
+        check(9 == ring.size() && live_rows(ring, 5), "live rows wrap around");
+
+        ring_type::view_type a, b;
+        ring.window(a, b);
+        check(5 == a.size() && 4 == b.size(), "two parts of the window");
+
+        // Only free slots are written
+        fill(batch, 14);
+        check(1 == ring.push_rows(batch) && ring.full(), "push into full ring");
+        check(live_rows(ring, 5), "rows of full ring");
+    }
+
+
+    void overwrite(void)
+    {
+        ring_type ring(10);
+        batch_type batch(4);
+        for (long k = 0; k < 10; ++k)
+        {
+            fill(batch, 4 * k);
+            ring.push_rows_overwrite(batch);
+        }
+        check(ring.full() && live_rows(ring, 30), "window of the last rows");
+
+        // Batch larger than the ring keeps its last rows
+        batch_type large(25);
+        fill(large, 100);
+        ring.push_rows_overwrite(large);
+        check(ring.full() && live_rows(ring, 115), "batch larger than capacity");
+    }
+
+
+    void producer(ring_type* ring, long rows)
+    {
+        batch_type batch(37);
+        long next = 0;
+        while (next < rows)
+        {
+            fill(batch, next);
+            const std::size_t count = rows - next < 37 ? static_cast<std::size_t>(rows - next) : 37;
+            next += static_cast<long>(ring->push_rows(batch, 0, count));
+        }
+    }
+
+
+    void producer_consumer(void)
+    {
+        const long rows = 200000;
+        ring_type ring(1000);
+        std::thread t(producer, &ring, rows);
+
+        long next = 0;
+        bool ordered = true;
+        while (next < rows)
+        {
+            ring_type::view_type a, b;
+            ring.window(a, b);
+            ordered = ordered && sequence(a, b, next);
+            ring.pop_rows(a.size() + b.size());
+            next += static_cast<long>(a.size() + b.size());
+        }
+        t.join();
+
+        check(ordered, "consumer sees rows in order");
+        check(ring.empty(), "consumer takes every row");
+    }
+
+} // end namespace test
+
+
+
+int main(void)
+{
+    test::wrap_around();
+    test::overwrite();
+    test::producer_consumer();
+
+    if (test::failures)
+    {
+        std::printf("%d failures\n", test::failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}